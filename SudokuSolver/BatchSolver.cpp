@@ -0,0 +1,578 @@
+#include "BatchSolver.h"
+
+#include "GridSolver.h"
+#include "LockstepSolver.h"
+#include "PuzzleParser.h"
+#include "SolutionCache.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace
+{
+    //Output is collected and written in chunks of about this size
+    const size_t OutputBufferSize = 64 * 1024;
+
+    //Lines handed to a worker thread at a time
+    const size_t LinesPerChunk = 1024;
+
+    //Packed records handed to a worker thread at a time
+    const size_t RecordsPerChunk = 1024;
+
+    //Puzzles the lockstep engine is given at a time, enough to fill its lanes with a few board types
+    const size_t PuzzlesPerLockstepBatch = 16 * LockstepLaneCount;
+
+    void AppendBoard( std::string& output, const SudokuBoard& sudokuBoard )
+    {
+        for( int row = 0; row < 9; row++ )
+        {
+            for( int col = 0; col < 9; col++ )
+            {
+                output += static_cast<char>( '0' + sudokuBoard.GetAt( row, col ) );
+            }
+        }
+    }
+
+    void AppendJsonField( std::string& output, const char* name, uint64_t value )
+    {
+        output += ",\"";
+        output += name;
+        output += "\":";
+        output += std::to_string( value );
+    }
+
+    void AppendJsonField( std::string& output, const char* name, double value )
+    {
+        char text[32];
+        std::snprintf( text, sizeof( text ), "%.9g", value );
+        output += ",\"";
+        output += name;
+        output += "\":";
+        output += text;
+    }
+
+    //One line of JSON per puzzle
+    void AppendStatsJson( std::string& output, size_t puzzleIndex, BoardType boardType, bool isSolved, const SolveStats& stats )
+    {
+        const char* boardTypeNames[] = { "traditional", "knight", "king", "queen" };
+
+        output += "{\"puzzle\":";
+        output += std::to_string( puzzleIndex );
+        output += ",\"boardType\":\"";
+        output += boardTypeNames[boardType];
+        output += isSolved ? "\",\"solved\":true" : "\",\"solved\":false";
+
+        AppendJsonField( output, "missingValuePlacements", stats.missingValuePlacements );
+        AppendJsonField( output, "only3x3SpotPlacements", stats.only3x3SpotPlacements );
+        AppendJsonField( output, "rowColSpotPlacements", stats.rowColSpotPlacements );
+        AppendJsonField( output, "tryingPossibilitiesPlacements", stats.tryingPossibilitiesPlacements );
+        AppendJsonField( output, "takingGuessPlacements", stats.takingGuessPlacements );
+        AppendJsonField( output, "searchSinglePlacements", stats.searchSinglePlacements );
+        AppendJsonField( output, "candidatesEliminated", stats.candidatesEliminated );
+        AppendJsonField( output, "boardCopies", stats.boardCopies );
+        AppendJsonField( output, "validityChecks", stats.validityChecks );
+        AppendJsonField( output, "guesses", stats.guesses );
+        AppendJsonField( output, "backtracks", stats.backtracks );
+        AppendJsonField( output, "maxGuessDepth", static_cast<uint64_t>( stats.maxGuessDepth ) );
+        AppendJsonField( output, "transpositionHits", stats.transpositionHits );
+        AppendJsonField( output, "transpositionMisses", stats.transpositionMisses );
+        AppendJsonField( output, "scratchAllocations", stats.scratchAllocations );
+        AppendJsonField( output, "missingValueSeconds", stats.missingValueSeconds );
+        AppendJsonField( output, "only3x3SpotSeconds", stats.only3x3SpotSeconds );
+        AppendJsonField( output, "rowColSpotSeconds", stats.rowColSpotSeconds );
+        AppendJsonField( output, "tryingPossibilitiesSeconds", stats.tryingPossibilitiesSeconds );
+        AppendJsonField( output, "takingGuessSeconds", stats.takingGuessSeconds );
+        AppendJsonField( output, "eliminatingSeconds", stats.eliminatingSeconds );
+        AppendJsonField( output, "searchSeconds", stats.searchSeconds );
+        output += ",\"hardestStrategy\":\"";
+        output += GetStrategyName( stats.hardestStrategy );
+        output += "\"}\n";
+    }
+
+    //Puzzles on the other grid sizes are written like 9x9 ones but with letters for 10 and up and
+    //can only be Traditional
+    bool ParseGridPuzzleLine( const std::string& line, std::string& placements )
+    {
+        size_t start = 0;
+        size_t colon = line.find( ':' );
+        if( colon != std::string::npos )
+        {
+            BoardType boardType;
+            if( !ParseBoardTypeTag( line.data(), colon, boardType ) || boardType != Traditional )
+                return false;
+            start = colon + 1;
+        }
+
+        placements.clear();
+        for( size_t i = start; i < line.size(); i++ )
+        {
+            char ch = line[i];
+            if( ch == '\r' || ch == ' ' || ch == '\t' )
+                continue;
+
+            if( GridValueFromChar( ch ) < 0 )
+                return false;
+            placements += ch;
+        }
+
+        return true;
+    }
+
+    bool IsSkippedLine( const std::string& line )
+    {
+        return line.empty() || line[0] == '#' || line == "\r";
+    }
+
+    void AddResult( BatchResult& total, const BatchResult& result )
+    {
+        total.puzzles += result.puzzles;
+        total.solved += result.solved;
+        total.invalid += result.invalid;
+        total.cached += result.cached;
+    }
+
+    //Solves puzzle lines and packed records, keeping what can be reused from one puzzle to the
+    //next.  Every thread has its own.
+    class LineSolver
+    {
+    public:
+        explicit LineSolver( const BatchOptions& options )
+        : _engine( options.engine )
+        , _packedOutput( options.packedOutput )
+        , _cache( options.cache )
+        {
+            //Only the human engine searches the same boards more than once
+            if( _engine == HumanStyleEngine )
+                _transpositions.emplace();
+        }
+
+        //statsOutput gets a line of JSON for the puzzle when it is given
+        void SolveLine( const std::string& line, size_t puzzleIndex, std::string& output, std::string* statsOutput, BatchResult& result )
+        {
+            BoardType boardType;
+            if( !ParsePuzzle( line, _values, boardType, &_parseError ) )
+            {
+                Flush( output, statsOutput, result );
+
+                SolveStats stats;
+                if( !_packedOutput && ParseGridPuzzleLine( line, _placements ) && SolveGridPuzzle( _placements, _solution, &stats ) )
+                {
+                    result.puzzles++;
+                    bool isSolved = !_solution.empty();
+                    if( isSolved )
+                        result.solved++;
+                    if( isSolved )
+                        output += _solution;
+                    else
+                        output += "unsolved";
+                    output += '\n';
+                    if( statsOutput != nullptr )
+                        AppendStatsJson( *statsOutput, puzzleIndex, Traditional, isSolved, stats );
+                    return;
+                }
+
+                AddInvalid( puzzleIndex, &_parseError, output, statsOutput, result );
+                return;
+            }
+
+            SolveBoard( SudokuBoard( _values, boardType ), puzzleIndex, output, statsOutput, result );
+        }
+
+        void SolveRecord( const PackedPuzzleView& record, size_t puzzleIndex, std::string& output, std::string* statsOutput, BatchResult& result )
+        {
+            if( !record.IsValid() )
+            {
+                Flush( output, statsOutput, result );
+                AddInvalid( puzzleIndex, nullptr, output, statsOutput, result );
+                return;
+            }
+
+            SolveBoard( record.GetBoard(), puzzleIndex, output, statsOutput, result );
+        }
+
+        //The lockstep engine holds puzzles back to solve many at once; this solves and writes out
+        //the ones it still has.  Has to be called at the end of a chunk.
+        void Flush( std::string& output, std::string* statsOutput, BatchResult& result )
+        {
+            if( _heldPuzzles.empty() )
+                return;
+
+            //Solutions from the cache are already full so go straight through
+            _heldStats.assign( _heldPuzzles.size(), SolveStats() );
+            SolveBatch( _heldSolutions.data(), _heldSolutions.size(), _heldStats.data() );
+
+            for( size_t i = 0; i < _heldPuzzles.size(); i++ )
+            {
+                if( _cache != nullptr && !_heldFromCache[i] )
+                    _cache->Add( _heldLookups[i], _heldSolutions[i] );
+                AppendSolution( _heldPuzzles[i], _heldSolutions[i], _heldPuzzleIndexes[i], _heldStats[i], output, statsOutput, result );
+            }
+            _heldPuzzles.clear();
+            _heldPuzzleIndexes.clear();
+            _heldSolutions.clear();
+            _heldLookups.clear();
+            _heldFromCache.clear();
+        }
+
+    private:
+        void SolveBoard( const SudokuBoard& puzzle, size_t puzzleIndex, std::string& output, std::string* statsOutput, BatchResult& result )
+        {
+            SudokuBoard sudokuBoard = puzzle;
+            bool isFromCache = _cache != nullptr && _cache->Find( puzzle, sudokuBoard, _lookup );
+            if( isFromCache )
+                result.cached++;
+
+            if( _engine == LockstepEngine )
+            {
+                _heldPuzzles.push_back( puzzle );
+                _heldPuzzleIndexes.push_back( puzzleIndex );
+                _heldSolutions.push_back( sudokuBoard );
+                if( _cache != nullptr )
+                {
+                    _heldLookups.push_back( _lookup );
+                    _heldFromCache.push_back( isFromCache );
+                }
+                if( _heldPuzzles.size() == PuzzlesPerLockstepBatch )
+                    Flush( output, statsOutput, result );
+                return;
+            }
+
+            SolveStats stats;
+            if( isFromCache )
+            {
+                AppendSolution( puzzle, sudokuBoard, puzzleIndex, stats, output, statsOutput, result );
+                return;
+            }
+
+            sudokuBoard = SolveWithEngine( sudokuBoard, _engine, &stats, _transpositions ? &*_transpositions : nullptr );
+
+            if( _cache != nullptr )
+                _cache->Add( _lookup, sudokuBoard );
+            AppendSolution( puzzle, sudokuBoard, puzzleIndex, stats, output, statsOutput, result );
+        }
+
+        void AppendSolution( const SudokuBoard& puzzle, const SudokuBoard& sudokuBoard, size_t puzzleIndex, const SolveStats& stats, std::string& output, std::string* statsOutput, BatchResult& result )
+        {
+            result.puzzles++;
+
+            bool isSolved = sudokuBoard.IsBoardSolved() && sudokuBoard.IsBoardValid();
+            if( isSolved )
+                result.solved++;
+
+            if( _packedOutput )
+            {
+                AppendPackedRecord( output, puzzle, isSolved ? &sudokuBoard : nullptr, true );
+            }
+            else if( isSolved )
+            {
+                AppendBoard( output, sudokuBoard );
+                output += '\n';
+            }
+            else
+            {
+                output += "unsolved\n";
+            }
+
+            if( statsOutput != nullptr )
+                AppendStatsJson( *statsOutput, puzzleIndex, puzzle.GetBoardType(), isSolved, stats );
+        }
+
+        //Packed output has no record for it.  The stats say what ParsePuzzle found wrong with a line.
+        void AddInvalid( size_t puzzleIndex, const ParseError* parseError, std::string& output, std::string* statsOutput, BatchResult& result )
+        {
+            result.puzzles++;
+            result.invalid++;
+            if( !_packedOutput )
+                output += "invalid\n";
+            if( statsOutput == nullptr )
+                return;
+
+            *statsOutput += "{\"puzzle\":";
+            *statsOutput += std::to_string( puzzleIndex );
+            *statsOutput += ",\"invalid\":true";
+            if( parseError != nullptr )
+            {
+                *statsOutput += ",\"error\":\"";
+                *statsOutput += parseError->message;
+                *statsOutput += "\",\"position\":";
+                *statsOutput += std::to_string( parseError->position );
+            }
+            *statsOutput += "}\n";
+        }
+
+        SolverEngine _engine;
+        bool _packedOutput;
+        SolutionCache* _cache;
+        SolutionCache::Lookup _lookup;
+        std::array<uint8_t, 9*9> _values;
+        ParseError _parseError;
+        std::string _placements;
+        std::string _solution;
+        std::optional<TranspositionTable> _transpositions;
+        std::vector<SudokuBoard> _heldPuzzles;
+        std::vector<size_t> _heldPuzzleIndexes;
+        std::vector<SudokuBoard> _heldSolutions;
+        std::vector<SolveStats> _heldStats;
+        std::vector<SolutionCache::Lookup> _heldLookups;
+        std::vector<bool> _heldFromCache;
+    };
+
+    struct Chunk
+    {
+        std::vector<std::string> lines;
+        size_t lineCount = 0;
+        size_t firstPuzzleIndex = 0;
+        std::string output;
+        std::string statsOutput;
+        BatchResult result;
+        bool isDone = false;
+    };
+
+    BatchResult SolveOnThisThread( std::istream& input, std::ostream& output, const BatchOptions& options )
+    {
+        BatchResult result;
+        LineSolver lineSolver( options );
+
+        std::string line;
+        std::string buffer;
+        std::string statsBuffer;
+        std::string* statsOutput = options.statsOutput != nullptr ? &statsBuffer : nullptr;
+        buffer.reserve( OutputBufferSize + 128 );
+
+        //The lockstep engine only counts puzzles in result once it has solved them
+        size_t puzzlesRead = 0;
+        while( std::getline( input, line ) )
+        {
+            if( IsSkippedLine( line ) )
+                continue;
+
+            lineSolver.SolveLine( line, puzzlesRead++, buffer, statsOutput, result );
+
+            if( buffer.size() >= OutputBufferSize )
+            {
+                output.write( buffer.data(), buffer.size() );
+                buffer.clear();
+            }
+            if( statsBuffer.size() >= OutputBufferSize )
+            {
+                options.statsOutput->write( statsBuffer.data(), statsBuffer.size() );
+                statsBuffer.clear();
+            }
+        }
+
+        lineSolver.Flush( buffer, statsOutput, result );
+        output.write( buffer.data(), buffer.size() );
+        if( statsOutput != nullptr )
+            options.statsOutput->write( statsBuffer.data(), statsBuffer.size() );
+        return result;
+    }
+
+    //The reading thread fills chunks of lines and hands them to the pool.  It keeps a bounded
+    //number of chunks in flight and, in order, writes out the ones that are done.
+    BatchResult SolveOnThreadPool( std::istream& input, std::ostream& output, const BatchOptions& options )
+    {
+        ThreadPool threadPool( options.threads );
+        std::vector<LineSolver> lineSolvers( threadPool.GetThreadCount(), LineSolver( options ) );
+        const size_t maxChunksInFlight = 4 * lineSolvers.size();
+
+        std::mutex mutex;
+        std::condition_variable chunkDone;
+        std::mutex outputMutex;
+
+        std::deque<std::unique_ptr<Chunk>> chunksInFlight;
+        std::vector<std::unique_ptr<Chunk>> spareChunks;
+        BatchResult total;
+        size_t puzzlesRead = 0;
+
+        auto retireChunks = [&]( size_t keepAtMost )
+        {
+            while( chunksInFlight.size() > keepAtMost )
+            {
+                std::unique_ptr<Chunk> chunk;
+                {
+                    std::unique_lock<std::mutex> lock( mutex );
+                    if( options.ordered )
+                    {
+                        chunkDone.wait( lock, [&]() { return chunksInFlight.front()->isDone; } );
+                        chunk = std::move( chunksInFlight.front() );
+                        chunksInFlight.pop_front();
+                    }
+                    else
+                    {
+                        auto isDone = []( const std::unique_ptr<Chunk>& c ) { return c->isDone; };
+                        chunkDone.wait( lock, [&]() { return std::any_of( chunksInFlight.begin(), chunksInFlight.end(), isDone ); } );
+                        auto it = std::find_if( chunksInFlight.begin(), chunksInFlight.end(), isDone );
+                        chunk = std::move( *it );
+                        chunksInFlight.erase( it );
+                    }
+                }
+
+                if( options.ordered )
+                {
+                    output.write( chunk->output.data(), chunk->output.size() );
+                    if( options.statsOutput != nullptr )
+                        options.statsOutput->write( chunk->statsOutput.data(), chunk->statsOutput.size() );
+                }
+
+                AddResult( total, chunk->result );
+                chunk->isDone = false;
+                spareChunks.push_back( std::move( chunk ) );
+            }
+        };
+
+        for( ;; )
+        {
+            std::unique_ptr<Chunk> chunk;
+            if( !spareChunks.empty() )
+            {
+                chunk = std::move( spareChunks.back() );
+                spareChunks.pop_back();
+            }
+            else
+            {
+                chunk = std::make_unique<Chunk>();
+                chunk->lines.resize( LinesPerChunk );
+            }
+
+            chunk->lineCount = 0;
+            while( chunk->lineCount < LinesPerChunk && std::getline( input, chunk->lines[chunk->lineCount] ) )
+            {
+                if( !IsSkippedLine( chunk->lines[chunk->lineCount] ) )
+                    chunk->lineCount++;
+            }
+
+            if( chunk->lineCount == 0 )
+                break;
+
+            chunk->firstPuzzleIndex = puzzlesRead;
+            puzzlesRead += chunk->lineCount;
+
+            Chunk* chunkToSolve = chunk.get();
+            threadPool.Submit( [&, chunkToSolve]( int workerIndex )
+            {
+                chunkToSolve->output.clear();
+                chunkToSolve->statsOutput.clear();
+                chunkToSolve->result = BatchResult();
+
+                std::string* statsOutput = options.statsOutput != nullptr ? &chunkToSolve->statsOutput : nullptr;
+                for( size_t i = 0; i < chunkToSolve->lineCount; i++ )
+                {
+                    lineSolvers[workerIndex].SolveLine( chunkToSolve->lines[i], chunkToSolve->firstPuzzleIndex + i, chunkToSolve->output, statsOutput, chunkToSolve->result );
+                }
+                lineSolvers[workerIndex].Flush( chunkToSolve->output, statsOutput, chunkToSolve->result );
+
+                if( !options.ordered )
+                {
+                    std::lock_guard<std::mutex> lock( outputMutex );
+                    output.write( chunkToSolve->output.data(), chunkToSolve->output.size() );
+                    if( statsOutput != nullptr )
+                        options.statsOutput->write( statsOutput->data(), statsOutput->size() );
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock( mutex );
+                    chunkToSolve->isDone = true;
+                }
+                chunkDone.notify_all();
+            });
+
+            chunksInFlight.push_back( std::move( chunk ) );
+            retireChunks( maxChunksInFlight - 1 );
+        }
+
+        retireChunks( 0 );
+
+        //The last tasks may still be returning after marking their chunk done
+        threadPool.Wait();
+        return total;
+    }
+}
+
+BatchResult SolvePuzzleStream( std::istream& input, std::ostream& output, const BatchOptions& options )
+{
+    if( options.packedOutput )
+    {
+        std::string header;
+        AppendPackedHeader( header, true );
+        output.write( header.data(), header.size() );
+    }
+
+    BatchResult result = options.threads == 1 ? SolveOnThisThread( input, output, options ) : SolveOnThreadPool( input, output, options );
+    output.flush();
+    if( options.statsOutput != nullptr )
+        options.statsOutput->flush();
+    return result;
+}
+
+BatchResult SolvePackedPuzzles( const PackedPuzzleFile& input, std::ostream& output, const BatchOptions& options )
+{
+    if( options.packedOutput )
+    {
+        std::string header;
+        AppendPackedHeader( header, true );
+        output.write( header.data(), header.size() );
+    }
+
+    ThreadPool threadPool( options.threads );
+    std::vector<LineSolver> lineSolvers( threadPool.GetThreadCount(), LineSolver( options ) );
+
+    //Chunks are written in order once every chunk of a round is done
+    struct RecordChunk
+    {
+        std::string output;
+        std::string statsOutput;
+        BatchResult result;
+    };
+    const size_t chunksPerRound = 4 * lineSolvers.size();
+    std::vector<RecordChunk> chunks( chunksPerRound );
+    BatchResult total;
+
+    size_t recordCount = input.GetRecordCount();
+    for( size_t roundStart = 0; roundStart < recordCount; roundStart += chunksPerRound * RecordsPerChunk )
+    {
+        for( size_t chunkIndex = 0; chunkIndex < chunksPerRound; chunkIndex++ )
+        {
+            size_t first = roundStart + chunkIndex * RecordsPerChunk;
+            size_t last = std::min( recordCount, first + RecordsPerChunk );
+            RecordChunk& chunk = chunks[chunkIndex];
+            chunk.output.clear();
+            chunk.statsOutput.clear();
+            chunk.result = BatchResult();
+            if( first >= last )
+                continue;
+
+            threadPool.Submit( [&, first, last]( int workerIndex )
+            {
+                std::string* statsOutput = options.statsOutput != nullptr ? &chunk.statsOutput : nullptr;
+                for( size_t i = first; i < last; i++ )
+                {
+                    lineSolvers[workerIndex].SolveRecord( input.GetRecord( i ), i, chunk.output, statsOutput, chunk.result );
+                }
+                lineSolvers[workerIndex].Flush( chunk.output, statsOutput, chunk.result );
+            });
+        }
+
+        threadPool.Wait();
+        for( const RecordChunk& chunk : chunks )
+        {
+            output.write( chunk.output.data(), chunk.output.size() );
+            if( options.statsOutput != nullptr )
+                options.statsOutput->write( chunk.statsOutput.data(), chunk.statsOutput.size() );
+            AddResult( total, chunk.result );
+        }
+    }
+
+    output.flush();
+    if( options.statsOutput != nullptr )
+        options.statsOutput->flush();
+    return total;
+}
\ No newline at end of file
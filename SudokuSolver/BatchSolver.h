@@ -0,0 +1,43 @@
+#pragma once
+
+#include "PackedPuzzle.h"
+#include "SolverEngine.h"
+#include "SudokuBoard.h"
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+class SolutionCache;
+
+struct BatchOptions
+{
+   SolverEngine engine = BacktrackingEngine;
+   int threads = 1;//0 uses every core
+   bool ordered = true;//false writes results as soon as they are ready, not in input order
+   std::ostream* statsOutput = nullptr;//When set gets a line of JSON with the SolveStats of every puzzle
+   //Writes a PackedPuzzle.h file of each puzzle and its solution instead of lines of text.  Only
+   //9x9 puzzles can be packed so lines of other sizes count as invalid.
+   bool packedOutput = false;
+   //When set, puzzles it has are not solved again and the ones solved are added to it
+   SolutionCache* cache = nullptr;
+};
+
+struct BatchResult
+{
+   size_t puzzles = 0;
+   size_t solved = 0;
+   size_t invalid = 0;//Lines that were not a puzzle
+   size_t cached = 0;//Puzzles BatchOptions::cache had the solution of
+};
+
+//Reads one puzzle per line from input and writes one line per puzzle to output: the values of
+//the solution, "unsolved" when there is no solution or "invalid" when the line is not a puzzle.
+//Lines that are not 9x9 puzzles can be Traditional puzzles of the other sizes SolveGridPuzzle takes.
+//Blank lines and lines starting with '#' are skipped.  With more than one thread the puzzles are
+//solved on a ThreadPool.
+BatchResult SolvePuzzleStream( std::istream& input, std::ostream& output, const BatchOptions& options );
+
+//The same for the records of a packed file, which are always written out in order.  Records with
+//a board type or values that cannot be are invalid.
+BatchResult SolvePackedPuzzles( const PackedPuzzleFile& input, std::ostream& output, const BatchOptions& options );
\ No newline at end of file
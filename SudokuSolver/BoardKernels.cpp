@@ -0,0 +1,370 @@
+#include "BoardKernels.h"
+
+#include "PeerTables.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    int FindSpotWithFewestCandidatesScalar( const uint16_t* candidates, const uint8_t* placements )
+    {
+        int bestIndex = -1;
+        int bestCount = 10;
+        for( int index = 0; index < 9*9; index++ )
+        {
+            if( placements[index] != 0 )
+                continue;
+
+            int count = CountCandidates( candidates[index] );
+            if( count < bestCount )
+            {
+                bestIndex = index;
+                bestCount = count;
+                if( count <= 1 )
+                    break;
+            }
+        }
+        return bestIndex;
+    }
+
+    void CountCandidatesOfAllSpotsScalar( const uint16_t* candidates, uint8_t* counts )
+    {
+        for( int index = 0; index < 9*9; index++ )
+        {
+            counts[index] = static_cast<uint8_t>( CountCandidates( candidates[index] ) );
+        }
+    }
+
+    //Only the 9s see along the diagonals so there are few enough of them to check pair by pair
+    bool HasNoNinesOnADiagonal( const uint8_t* placements )
+    {
+        int rows[9*9], cols[9*9];
+        int nines = 0;
+        for( int index = 0; index < 9*9; index++ )
+        {
+            if( placements[index] != 9 )
+                continue;
+
+            for( int i = 0; i < nines; i++ )
+            {
+                if( std::abs( rows[i] - index / 9 ) == std::abs( cols[i] - index % 9 ) )
+                    return false;
+            }
+            rows[nines] = index / 9;
+            cols[nines] = index % 9;
+            nines++;
+        }
+        return true;
+    }
+
+    bool HasNoConflictingPeersScalar( const uint8_t* placements, BoardType boardType )
+    {
+        for( const auto& unit : Units )
+        {
+            uint16_t seen = 0;
+            for( uint8_t index : unit )
+            {
+                int value = placements[index];
+                if( value == 0 )
+                    continue;
+
+                if( seen & CandidateBit( value ) )
+                    return false;
+                seen |= CandidateBit( value );
+            }
+        }
+
+        if( boardType == QueenSudoku )
+            return HasNoNinesOnADiagonal( placements );
+
+        const PeerTable& variantPeers = VariantPeers[boardType];
+        for( int index = 0; index < 9*9; index++ )
+        {
+            int value = placements[index];
+            if( value == 0 )
+                continue;
+
+            const PeerList& peers = variantPeers[index];
+            for( int i = 0; i < peers.count; i++ )
+            {
+                if( placements[peers.cells[i]] == value )
+                    return false;
+            }
+        }
+        return true;
+    }
+
+#if defined(SUDOKU_X86_KERNELS)
+    //Bits set in each value of a nibble, for pshufb
+    SUDOKU_TARGET( "sse4.1" ) __m128i NibbleBitCounts()
+    {
+        return _mm_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+    }
+
+    //The bits set in each of 8 16 bit masks
+    SUDOKU_TARGET( "sse4.1" ) __m128i CountBits16( __m128i masks )
+    {
+        const __m128i lowNibbles = _mm_set1_epi8( 0x0F );
+        __m128i byteCounts = _mm_add_epi8( _mm_shuffle_epi8( NibbleBitCounts(), _mm_and_si128( masks, lowNibbles ) ),
+                                           _mm_shuffle_epi8( NibbleBitCounts(), _mm_and_si128( _mm_srli_epi16( masks, 4 ), lowNibbles ) ) );
+        return _mm_maddubs_epi16( byteCounts, _mm_set1_epi8( 1 ) );
+    }
+
+    //Filled spots get 0xFFFF so they never come out smallest and a count of 0 counts as 1 since the
+    //search stops at the first spot with either.  minpos then gives the first smallest of 8 at once.
+    SUDOKU_TARGET( "sse4.1" ) bool TakeSmallerKey( __m128i keys, int first, int& bestKey, int& bestIndex )
+    {
+        __m128i least = _mm_minpos_epu16( keys );
+        int key = _mm_extract_epi16( least, 0 );
+        if( key >= bestKey )
+            return false;
+
+        bestKey = key;
+        bestIndex = first + _mm_extract_epi16( least, 1 );
+        return key <= 1;
+    }
+
+    int TakeLastSpot( const uint16_t* candidates, const uint8_t* placements, int bestKey, int bestIndex )
+    {
+        const int last = 9*9 - 1;
+        if( placements[last] == 0 && std::max( CountCandidates( candidates[last] ), 1 ) < bestKey )
+            return last;
+        return bestIndex;
+    }
+
+    SUDOKU_TARGET( "sse4.1" ) int FindSpotWithFewestCandidatesSse41( const uint16_t* candidates, const uint8_t* placements )
+    {
+        int bestKey = 0xFFFF;
+        int bestIndex = -1;
+        for( int first = 0; first + 8 <= 9*9; first += 8 )
+        {
+            __m128i counts = CountBits16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( candidates + first ) ) );
+            __m128i values = _mm_cvtepu8_epi16( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( placements + first ) ) );
+            __m128i filled = _mm_cmpgt_epi16( values, _mm_setzero_si128() );
+            __m128i keys = _mm_or_si128( _mm_max_epu16( counts, _mm_set1_epi16( 1 ) ), filled );
+            if( TakeSmallerKey( keys, first, bestKey, bestIndex ) )
+                return bestIndex;
+        }
+        return TakeLastSpot( candidates, placements, bestKey, bestIndex );
+    }
+
+    SUDOKU_TARGET( "sse4.1" ) void CountCandidatesOfAllSpotsSse41( const uint16_t* candidates, uint8_t* counts )
+    {
+        for( int first = 0; first + 8 <= 9*9; first += 8 )
+        {
+            __m128i spotCounts = CountBits16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( candidates + first ) ) );
+            _mm_storel_epi64( reinterpret_cast<__m128i*>( counts + first ), _mm_packus_epi16( spotCounts, spotCounts ) );
+        }
+        counts[9*9 - 1] = static_cast<uint8_t>( CountCandidates( candidates[9*9 - 1] ) );
+    }
+
+    SUDOKU_TARGET( "avx2" ) __m256i CountBits16( __m256i masks )
+    {
+        const __m256i lowNibbles = _mm256_set1_epi8( 0x0F );
+        const __m256i nibbleBitCounts = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+        __m256i byteCounts = _mm256_add_epi8( _mm256_shuffle_epi8( nibbleBitCounts, _mm256_and_si256( masks, lowNibbles ) ),
+                                              _mm256_shuffle_epi8( nibbleBitCounts, _mm256_and_si256( _mm256_srli_epi16( masks, 4 ), lowNibbles ) ) );
+        return _mm256_maddubs_epi16( byteCounts, _mm256_set1_epi8( 1 ) );
+    }
+
+    SUDOKU_TARGET( "avx2" ) int FindSpotWithFewestCandidatesAvx2( const uint16_t* candidates, const uint8_t* placements )
+    {
+        int bestKey = 0xFFFF;
+        int bestIndex = -1;
+        for( int first = 0; first + 16 <= 9*9; first += 16 )
+        {
+            __m256i counts = CountBits16( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( candidates + first ) ) );
+            __m256i values = _mm256_cvtepu8_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( placements + first ) ) );
+            __m256i filled = _mm256_cmpgt_epi16( values, _mm256_setzero_si256() );
+            __m256i keys = _mm256_or_si256( _mm256_max_epu16( counts, _mm256_set1_epi16( 1 ) ), filled );
+
+            //minpos only comes in 128 bits
+            if( TakeSmallerKey( _mm256_castsi256_si128( keys ), first, bestKey, bestIndex ) ||
+                TakeSmallerKey( _mm256_extracti128_si256( keys, 1 ), first + 8, bestKey, bestIndex ) )
+                return bestIndex;
+        }
+        return TakeLastSpot( candidates, placements, bestKey, bestIndex );
+    }
+
+    SUDOKU_TARGET( "avx2" ) void CountCandidatesOfAllSpotsAvx2( const uint16_t* candidates, uint8_t* counts )
+    {
+        for( int first = 0; first + 16 <= 9*9; first += 16 )
+        {
+            __m256i spotCounts = CountBits16( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( candidates + first ) ) );
+            __m128i packed = _mm_packus_epi16( _mm256_castsi256_si128( spotCounts ), _mm256_extracti128_si256( spotCounts, 1 ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( counts + first ), packed );
+        }
+        counts[9*9 - 1] = static_cast<uint8_t>( CountCandidates( candidates[9*9 - 1] ) );
+    }
+
+    //spotsWithValue has the spots holding each value 1-9.  Every spot holding a value is checked
+    //against its peers with that value at once, so the variants cost no more than the units do.
+    SUDOKU_TARGET( "sse4.1" ) bool HasNoValueSeeingItself( const SpotSet* spotsWithValue, BoardType boardType )
+    {
+        for( int value = 1; value <= 9; value++ )
+        {
+            const SpotSet& spots = spotsWithValue[value];
+            __m128i spotBits = _mm_loadu_si128( reinterpret_cast<const __m128i*>( spots.words ) );
+            const auto& peerSpotSets = PeerSpotSets[VariantPeersConstrain( boardType, value ) ? boardType : Traditional];
+            for( int word = 0; word < 2; word++ )
+            {
+                for( uint64_t bits = spots.words[word]; bits != 0; bits &= bits - 1 )
+                {
+                    const SpotSet& peers = peerSpotSets[word*64 + FindLowestBit( bits )];
+                    if( !_mm_testz_si128( spotBits, _mm_loadu_si128( reinterpret_cast<const __m128i*>( peers.words ) ) ) )
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    //The spots holding a value come from comparing 16 or 32 placements with it at once.  The last
+    //load ends at spot 80 so overlaps the one before it rather than reading past the board.
+    SUDOKU_TARGET( "sse4.1" ) bool HasNoConflictingPeersSse41( const uint8_t* placements, BoardType boardType )
+    {
+        SpotSet spotsWithValue[9 + 1];
+        for( int value = 1; value <= 9; value++ )
+        {
+            __m128i valueBytes = _mm_set1_epi8( static_cast<char>( value ) );
+            uint64_t masks[5];
+            for( int chunk = 0; chunk < 5; chunk++ )
+            {
+                __m128i chunkValues = _mm_loadu_si128( reinterpret_cast<const __m128i*>( placements + chunk*16 ) );
+                masks[chunk] = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi8( chunkValues, valueBytes ) ) );
+            }
+            __m128i lastValues = _mm_loadu_si128( reinterpret_cast<const __m128i*>( placements + 9*9 - 16 ) );
+            uint64_t lastMask = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi8( lastValues, valueBytes ) ) ) >> 15;
+
+            spotsWithValue[value].words[0] = masks[0] | ( masks[1] << 16 ) | ( masks[2] << 32 ) | ( masks[3] << 48 );
+            spotsWithValue[value].words[1] = masks[4] | ( lastMask << 16 );
+        }
+        return HasNoValueSeeingItself( spotsWithValue, boardType );
+    }
+
+    SUDOKU_TARGET( "avx2" ) bool HasNoConflictingPeersAvx2( const uint8_t* placements, BoardType boardType )
+    {
+        __m256i firstValues = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( placements ) );
+        __m256i secondValues = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( placements + 32 ) );
+        __m256i lastValues = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( placements + 9*9 - 32 ) );
+
+        SpotSet spotsWithValue[9 + 1];
+        for( int value = 1; value <= 9; value++ )
+        {
+            __m256i valueBytes = _mm256_set1_epi8( static_cast<char>( value ) );
+            uint64_t firstMask = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( firstValues, valueBytes ) ) );
+            uint64_t secondMask = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( secondValues, valueBytes ) ) );
+            uint64_t lastMask = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( lastValues, valueBytes ) ) ) >> 15;
+
+            spotsWithValue[value].words[0] = firstMask | ( secondMask << 32 );
+            spotsWithValue[value].words[1] = lastMask;
+        }
+        return HasNoValueSeeingItself( spotsWithValue, boardType );
+    }
+
+    BoardKernelSet DetectBoardKernelSet()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid( info, 0 );
+        int maxLeaf = info[0];
+        __cpuid( info, 1 );
+        bool hasSse41 = ( info[2] & ( 1 << 19 ) ) != 0;
+        //AVX2 also needs the OS to save the ymm registers
+        bool osSavesYmm = ( info[2] & ( 1 << 27 ) ) != 0 && ( _xgetbv( 0 ) & 6 ) == 6;
+        bool hasAvx2 = false;
+        if( maxLeaf >= 7 && osSavesYmm )
+        {
+            __cpuidex( info, 7, 0 );
+            hasAvx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool hasSse41 = __builtin_cpu_supports( "sse4.1" );
+        bool hasAvx2 = __builtin_cpu_supports( "avx2" );
+#endif
+        if( hasAvx2 )
+            return Avx2Kernels;
+        if( hasSse41 )
+            return Sse41Kernels;
+        return ScalarKernels;
+    }
+#else
+    BoardKernelSet DetectBoardKernelSet()
+    {
+        return ScalarKernels;
+    }
+#endif
+
+    struct BoardKernels
+    {
+        int ( *findSpotWithFewestCandidates )( const uint16_t* candidates, const uint8_t* placements );
+        void ( *countCandidatesOfAllSpots )( const uint16_t* candidates, uint8_t* counts );
+        bool ( *hasNoConflictingPeers )( const uint8_t* placements, BoardType boardType );
+    };
+
+    BoardKernels GetKernels( BoardKernelSet kernelSet )
+    {
+#if defined(SUDOKU_X86_KERNELS)
+        if( kernelSet == Avx2Kernels )
+            return { FindSpotWithFewestCandidatesAvx2, CountCandidatesOfAllSpotsAvx2, HasNoConflictingPeersAvx2 };
+        if( kernelSet == Sse41Kernels )
+            return { FindSpotWithFewestCandidatesSse41, CountCandidatesOfAllSpotsSse41, HasNoConflictingPeersSse41 };
+#endif
+        return { FindSpotWithFewestCandidatesScalar, CountCandidatesOfAllSpotsScalar, HasNoConflictingPeersScalar };
+    }
+
+    struct ActiveKernels
+    {
+        BoardKernelSet kernelSet;
+        BoardKernels kernels;
+    };
+
+    ActiveKernels& GetActiveKernels()
+    {
+        static ActiveKernels active = { GetBestBoardKernelSet(), GetKernels( GetBestBoardKernelSet() ) };
+        return active;
+    }
+}
+
+BoardKernelSet GetBestBoardKernelSet()
+{
+    static const BoardKernelSet best = DetectBoardKernelSet();
+    return best;
+}
+
+void UseBoardKernelSet( BoardKernelSet kernelSet )
+{
+    if( kernelSet > GetBestBoardKernelSet() )
+        kernelSet = GetBestBoardKernelSet();
+
+    GetActiveKernels() = { kernelSet, GetKernels( kernelSet ) };
+}
+
+BoardKernelSet GetBoardKernelSet()
+{
+    return GetActiveKernels().kernelSet;
+}
+
+const char* GetBoardKernelSetName( BoardKernelSet kernelSet )
+{
+    const char* names[] = { "scalar", "sse4.1", "avx2" };
+    return names[kernelSet];
+}
+
+int FindSpotWithFewestCandidates( const uint16_t* candidates, const uint8_t* placements )
+{
+    return GetActiveKernels().kernels.findSpotWithFewestCandidates( candidates, placements );
+}
+
+void CountCandidatesOfAllSpots( const uint16_t* candidates, uint8_t* counts )
+{
+    GetActiveKernels().kernels.countCandidatesOfAllSpots( candidates, counts );
+}
+
+bool HasNoConflictingPeers( const uint8_t* placements, BoardType boardType )
+{
+    return GetActiveKernels().kernels.hasNoConflictingPeers( placements, boardType );
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SUDOKU_X86_KERNELS 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+//GCC and Clang only let a function use instructions the whole file was not compiled for when it
+//says so; MSVC always does.  Only for functions picked at run time after checking the CPU.
+#if defined(SUDOKU_X86_KERNELS) && ( defined(__GNUC__) || defined(__clang__) )
+#define SUDOKU_TARGET( instructions ) __attribute__(( target( instructions ) ))
+#else
+#define SUDOKU_TARGET( instructions )
+#endif
+
+//Loops over the whole board written with SSE4.1 and AVX2 as well as plain C++.  The best set the
+//CPU runs is picked the first time one is called; SudokuBoard calls them so nothing else has to.
+enum BoardKernelSet : uint8_t
+{
+   ScalarKernels,
+   Sse41Kernels,
+   Avx2Kernels
+};
+
+BoardKernelSet GetBestBoardKernelSet();
+//For comparing them, e.g. in the benchmarks.  Not to be called while other threads use them.
+void UseBoardKernelSet( BoardKernelSet kernelSet );
+BoardKernelSet GetBoardKernelSet();
+const char* GetBoardKernelSetName( BoardKernelSet kernelSet );
+
+//candidates and placements are the 81 spots of a board row by row.  Returns the empty spot with the
+//fewest candidates, the first one with 0 or 1 if there is one, or -1 if there are no empty spots.
+int FindSpotWithFewestCandidates( const uint16_t* candidates, const uint8_t* placements );
+
+//counts gets how many bits each of the 81 masks has
+void CountCandidatesOfAllSpots( const uint16_t* candidates, uint8_t* counts );
+
+//Whether no two peers hold the same value.  placements have to be 0 to 9.
+bool HasNoConflictingPeers( const uint8_t* placements, BoardType boardType );
\ No newline at end of file
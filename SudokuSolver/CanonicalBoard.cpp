@@ -0,0 +1,347 @@
+#include "CanonicalBoard.h"
+
+#include "ScratchArena.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    //The 6 orders of 3 things
+    const uint8_t Orders3[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+    //An order of the 9 columns that keeps the stacks whole: the stacks in one of the 6 orders and
+    //the columns of the stack that goes at each position in one of them too
+    struct ColumnOrder
+    {
+        uint8_t stacks;
+        uint8_t withinStacks[3];
+
+        int GetColumnAt( int position ) const
+        {
+            return Orders3[stacks][position / 3] * 3 + Orders3[withinStacks[position / 3]][position % 3];
+        }
+    };
+
+    //A row's filled spots are 9 bits with column 0 the highest, so a smaller mask is a row filled
+    //later.  Each stack is 3 of those bits, and this has them for each order within a stack.
+    struct StackMasks
+    {
+        uint8_t masks[6][8];
+    };
+
+    constexpr StackMasks MakeStackMasks()
+    {
+        StackMasks result = {};
+        for( int order = 0; order < 6; order++ )
+        {
+            for( int mask = 0; mask < 8; mask++ )
+            {
+                for( int i = 0; i < 3; i++ )
+                    result.masks[order][mask] |= ( ( mask >> ( 2 - Orders3[order][i] ) ) & 1 ) << ( 2 - i );
+            }
+        }
+        return result;
+    }
+
+    const StackMasks OrderedStackMasks = MakeStackMasks();
+
+    int GetStackMask( uint16_t rowMask, int stack )
+    {
+        return ( rowMask >> ( 6 - 3*stack ) ) & 7;
+    }
+
+    uint16_t PermuteRowMask( uint16_t mask, const ColumnOrder& columnOrder )
+    {
+        const uint8_t* stacks = Orders3[columnOrder.stacks];
+        uint16_t result = 0;
+        for( int i = 0; i < 3; i++ )
+            result = static_cast<uint16_t>( ( result << 3 ) | OrderedStackMasks.masks[columnOrder.withinStacks[i]][GetStackMask( mask, stacks[i] )] );
+        return result;
+    }
+
+    //Calls found( columnOrder ) for every column order that turns mask into permuted
+    template<typename Found>
+    void ForEachColumnOrderGiving( uint16_t mask, uint16_t permuted, Found found )
+    {
+        for( int stacks = 0; stacks < 6; stacks++ )
+        {
+            //The orders within each stack that give its part of permuted
+            uint8_t withinStacks[3][6];
+            int counts[3] = {};
+            for( int i = 0; i < 3; i++ )
+            {
+                int stackMask = GetStackMask( mask, Orders3[stacks][i] );
+                for( int order = 0; order < 6; order++ )
+                {
+                    if( OrderedStackMasks.masks[order][stackMask] == GetStackMask( permuted, i ) )
+                        withinStacks[i][counts[i]++] = static_cast<uint8_t>( order );
+                }
+            }
+
+            for( int first = 0; first < counts[0]; first++ )
+            {
+                for( int second = 0; second < counts[1]; second++ )
+                {
+                    for( int third = 0; third < counts[2]; third++ )
+                        found( ColumnOrder{ static_cast<uint8_t>( stacks ), { withinStacks[0][first], withinStacks[1][second], withinStacks[2][third] } } );
+                }
+            }
+        }
+    }
+
+    //The smallest a row mask can be made by a column order: each stack's spots packed to its end
+    //and the stacks with the fewest filled spots first
+    uint16_t SmallestRowMask( uint16_t mask )
+    {
+        int counts[3];
+        for( int stack = 0; stack < 3; stack++ )
+            counts[stack] = CountCandidates( static_cast<uint16_t>( GetStackMask( mask, stack ) ) );
+        std::sort( counts, counts + 3 );
+
+        uint16_t result = 0;
+        for( int stack = 0; stack < 3; stack++ )
+            result = static_cast<uint16_t>( ( result << 3 ) | ( ( 1 << counts[stack] ) - 1 ) );
+        return result;
+    }
+
+    //Keeps whichever of the rearrangements it is shown gives the smallest board
+    class SmallestRearrangement
+    {
+    public:
+        SmallestRearrangement( const SudokuBoard& sudokuBoard )
+        : _boardType( sudokuBoard.GetBoardType() )
+        , _found( false )
+        {
+            for( int index = 0; index < 9*9; index++ )
+                _values[index] = static_cast<uint8_t>( sudokuBoard.GetAt( index / 9, index % 9 ) );
+        }
+
+        void Consider( const std::array<uint8_t, 9*9>& spots )
+        {
+            std::array<uint8_t, 10> relabels = {};
+            uint8_t nextValue = 1;
+            if( _boardType == QueenSudoku )
+                relabels[9] = 9;
+
+            //Both go smallest first, so a rearrangement can be dropped as soon as it is bigger
+            bool isSmaller = !_found;
+            std::array<uint8_t, 9*9> rearranged;
+            for( int index = 0; index < 9*9; index++ )
+            {
+                int value = _values[spots[index]];
+                if( value != 0 && relabels[value] == 0 )
+                    relabels[value] = nextValue++;
+                rearranged[index] = relabels[value];
+
+                if( isSmaller )
+                    continue;
+                if( ( rearranged[index] != 0 ) != ( _best[index] != 0 ) )
+                {
+                    if( rearranged[index] != 0 )
+                        return;
+                    isSmaller = true;
+                }
+            }
+
+            if( !isSmaller )
+            {
+                if( !std::lexicographical_compare( rearranged.begin(), rearranged.end(), _best.begin(), _best.end() ) )
+                    return;
+            }
+
+            //Values never seen get whatever labels are left so the map stays one to one
+            for( int value = 1; value <= 9; value++ )
+            {
+                if( relabels[value] == 0 )
+                    relabels[value] = nextValue++;
+            }
+
+            _found = true;
+            _best = rearranged;
+            _symmetry.spots = spots;
+            _symmetry.values = relabels;
+        }
+
+        SudokuBoard GetBoard() const { return SudokuBoard( _best, _boardType ); }
+        const BoardSymmetry& GetSymmetry() const { return _symmetry; }
+
+    private:
+        BoardType _boardType;
+        std::array<uint8_t, 9*9> _values;
+        bool _found;
+        std::array<uint8_t, 9*9> _best;
+        BoardSymmetry _symmetry;
+    };
+
+    //Row orders and column orders of the board or its transpose that give the same, smallest, rows
+    //so far
+    struct PartialRearrangement
+    {
+        ColumnOrder columnOrder;
+        bool transposed;
+        uint16_t usedRows;
+        uint8_t rows[9];
+    };
+
+    //Picks the rows one at a time, keeping every rearrangement that gives the smallest row mask
+    //so far; the values only get compared between the ones left at the end
+    void ConsiderTraditionalRearrangements( const SudokuBoard& sudokuBoard, SmallestRearrangement& smallest )
+    {
+        uint16_t rowMasks[2][9] = {};
+        for( int row = 0; row < 9; row++ )
+        {
+            for( int col = 0; col < 9; col++ )
+            {
+                if( sudokuBoard.GetAt( row, col ) == 0 )
+                    continue;
+                rowMasks[0][row] |= 1 << ( 8 - col );
+                rowMasks[1][col] |= 1 << ( 8 - row );
+            }
+        }
+
+        //Every column order only needs trying with the rows that can go first
+        uint16_t best = 0xFFFF;
+        for( const auto& masks : rowMasks )
+        {
+            for( uint16_t mask : masks )
+                best = std::min( best, SmallestRowMask( mask ) );
+        }
+
+        ScratchScope scope;
+        PartialRearrangement* rearrangements = scope.GetArena().Allocate<PartialRearrangement>( CanonicalSearchLimit );
+        PartialRearrangement* next = scope.GetArena().Allocate<PartialRearrangement>( CanonicalSearchLimit );
+        int rearrangementCount = 0;
+        int nextCount = 0;
+        for( int transposed = 0; transposed < 2; transposed++ )
+        {
+            for( int row = 0; row < 9; row++ )
+            {
+                if( SmallestRowMask( rowMasks[transposed][row] ) != best )
+                    continue;
+
+                ForEachColumnOrderGiving( rowMasks[transposed][row], best, [&]( const ColumnOrder& columnOrder )
+                {
+                    if( rearrangementCount >= CanonicalSearchLimit )
+                        return;
+
+                    PartialRearrangement rearrangement = {};
+                    rearrangement.columnOrder = columnOrder;
+                    rearrangement.transposed = transposed != 0;
+                    rearrangement.usedRows = static_cast<uint16_t>( 1 << row );
+                    rearrangement.rows[0] = static_cast<uint8_t>( row );
+                    rearrangements[rearrangementCount++] = rearrangement;
+                });
+            }
+        }
+
+        for( int position = 1; position < 9; position++ )
+        {
+            best = 0xFFFF;
+            nextCount = 0;
+            for( int i = 0; i < rearrangementCount; i++ )
+            {
+                const PartialRearrangement& rearrangement = rearrangements[i];
+                //A new band can be any one not started yet, otherwise the row comes from the same band
+                int bandStart = rearrangement.rows[position - position % 3] / 3 * 3;
+                for( int row = 0; row < 9; row++ )
+                {
+                    if( rearrangement.usedRows & ( 1 << row ) )
+                        continue;
+                    if( position % 3 != 0 && row / 3 * 3 != bandStart )
+                        continue;
+                    if( position % 3 == 0 && ( rearrangement.usedRows >> ( row / 3 * 3 ) & 7 ) != 0 )
+                        continue;
+
+                    uint16_t mask = PermuteRowMask( rowMasks[rearrangement.transposed][row], rearrangement.columnOrder );
+                    if( mask > best )
+                        continue;
+                    if( mask < best )
+                    {
+                        best = mask;
+                        nextCount = 0;
+                    }
+                    if( nextCount >= CanonicalSearchLimit )
+                        continue;
+
+                    PartialRearrangement longer = rearrangement;
+                    longer.usedRows |= 1 << row;
+                    longer.rows[position] = static_cast<uint8_t>( row );
+                    next[nextCount++] = longer;
+                }
+            }
+            std::swap( rearrangements, next );
+            rearrangementCount = nextCount;
+        }
+
+        for( int i = 0; i < rearrangementCount; i++ )
+        {
+            const PartialRearrangement& rearrangement = rearrangements[i];
+            std::array<uint8_t, 9*9> spots;
+            for( int row = 0; row < 9; row++ )
+            {
+                for( int col = 0; col < 9; col++ )
+                {
+                    int fromRow = rearrangement.rows[row];
+                    int fromCol = rearrangement.columnOrder.GetColumnAt( col );
+                    spots[row*9 + col] = static_cast<uint8_t>( rearrangement.transposed ? fromCol*9 + fromRow : fromRow*9 + fromCol );
+                }
+            }
+            smallest.Consider( spots );
+        }
+    }
+
+    //The 8 rotations and reflections
+    void ConsiderRotationsAndReflections( SmallestRearrangement& smallest )
+    {
+        for( int transform = 0; transform < 8; transform++ )
+        {
+            std::array<uint8_t, 9*9> spots;
+            for( int row = 0; row < 9; row++ )
+            {
+                for( int col = 0; col < 9; col++ )
+                {
+                    int fromRow = transform & 1 ? 8 - row : row;
+                    int fromCol = transform & 2 ? 8 - col : col;
+                    if( transform & 4 )
+                        std::swap( fromRow, fromCol );
+                    spots[row*9 + col] = static_cast<uint8_t>( fromRow*9 + fromCol );
+                }
+            }
+            smallest.Consider( spots );
+        }
+    }
+}
+
+SudokuBoard BoardSymmetry::Apply( const SudokuBoard& sudokuBoard ) const
+{
+    std::array<uint8_t, 9*9> rearranged;
+    for( int index = 0; index < 9*9; index++ )
+        rearranged[index] = values[sudokuBoard.GetAt( spots[index] / 9, spots[index] % 9 )];
+    return SudokuBoard( rearranged, sudokuBoard.GetBoardType() );
+}
+
+SudokuBoard BoardSymmetry::Reverse( const SudokuBoard& sudokuBoard ) const
+{
+    std::array<uint8_t, 10> originalValues = {};
+    for( int value = 1; value <= 9; value++ )
+        originalValues[values[value]] = static_cast<uint8_t>( value );
+
+    std::array<uint8_t, 9*9> original;
+    for( int index = 0; index < 9*9; index++ )
+        original[spots[index]] = originalValues[sudokuBoard.GetAt( index / 9, index % 9 )];
+    return SudokuBoard( original, sudokuBoard.GetBoardType() );
+}
+
+SudokuBoard Canonicalize( const SudokuBoard& sudokuBoard, BoardSymmetry* symmetry /*= nullptr*/ )
+{
+    SmallestRearrangement smallest( sudokuBoard );
+    if( sudokuBoard.GetBoardType() == Traditional )
+        ConsiderTraditionalRearrangements( sudokuBoard, smallest );
+    else
+        ConsiderRotationsAndReflections( smallest );
+
+    if( symmetry != nullptr )
+        *symmetry = smallest.GetSymmetry();
+    return smallest.GetBoard();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <array>
+#include <cstdint>
+
+//A rearrangement that keeps a board type's rules: the spots moved around and the values
+//relabelled.  A solution of a board, rearranged the same way, solves the rearranged board.
+struct BoardSymmetry
+{
+   std::array<uint8_t, 9*9> spots;//The spot of the original board each spot takes its value from
+   std::array<uint8_t, 10> values;//What each value becomes; 0 stays 0
+
+   SudokuBoard Apply( const SudokuBoard& sudokuBoard ) const;
+   //Takes a board Apply rearranged back to how it was
+   SudokuBoard Reverse( const SudokuBoard& sudokuBoard ) const;
+};
+
+//Rearrangements of a Traditional board tied for smallest that Canonicalize follows at once.  Only
+//boards with hardly any clues or hardly any empty spots get near it; past it some are dropped, so
+//two rearrangements of such a board can get different results.
+const int CanonicalSearchLimit = 1 << 14;
+
+//The smallest board the symmetries of its board type turn sudokuBoard into, so that puzzles that
+//are rearrangements of each other can be looked up as one.  Smallest means the filled spots come
+//as late as they can reading row by row, then the values are the smallest with each value
+//relabelled in the order it first appears.  Every board type can be rotated and reflected;
+//Traditional boards can also have their bands, their stacks and the rows and columns within them
+//put in any order.  A QueenSudoku's diagonals only constrain the 9s so they are never relabelled.
+//symmetry, when given, gets the rearrangement that gives the result.
+SudokuBoard Canonicalize( const SudokuBoard& sudokuBoard, BoardSymmetry* symmetry = nullptr );
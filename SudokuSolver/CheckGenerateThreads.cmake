@@ -0,0 +1,21 @@
+# Runs SudokuSolver --generate with the same seed on 1 and on 3 threads and fails unless the
+# output is the same.  SUDOKU_SOLVER is the path of the executable.  There are more puzzles than
+# fit in one chunk of PuzzlesPerChunk so that the workers share them.
+foreach(boardType traditional knight king queen)
+  set(outputs "")
+  foreach(threads 1 3)
+    execute_process(COMMAND ${SUDOKU_SOLVER} --generate 200 --board-type ${boardType} --seed 5 --threads ${threads}
+                    OUTPUT_VARIABLE output
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+      message(FATAL_ERROR "--generate on ${threads} threads failed for ${boardType}")
+    endif()
+    list(APPEND outputs "${output}")
+  endforeach()
+
+  list(GET outputs 0 oneThread)
+  list(GET outputs 1 threeThreads)
+  if(NOT oneThread STREQUAL threeThreads)
+    message(FATAL_ERROR "--generate gave different ${boardType} puzzles on 1 and 3 threads")
+  endif()
+endforeach()
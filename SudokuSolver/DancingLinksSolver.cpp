@@ -0,0 +1,337 @@
+#include "DancingLinksSolver.h"
+
+#include "PeerTables.h"
+#include "ScratchArena.h"
+
+#include <algorithm>
+
+#include <cassert>
+
+namespace
+{
+    const int Root = 0;
+
+    //Primary columns: spot filled, value in row, value in column, value in 3x3 grid
+    const int SpotColumns = 0;
+    const int RowColumns = 81;
+    const int ColColumns = 2*81;
+    const int GridColumns = 3*81;
+    const int PrimaryColumnCount = 4*81;
+
+    //A row has its 4 primary columns plus at most 8 knight/king peers (or 2 queen diagonals)
+    const int MaxColumnsPerRow = 4 + 8;
+
+    //Knight and king boards can have a secondary column for every pair of variant peers and value
+    const int MaxColumnCount = PrimaryColumnCount + 9*9*8*9 / 2;
+    const int MaxNodeCount = 1 + MaxColumnCount + 9*9*9*MaxColumnsPerRow;
+
+    bool ShareUnit( int index, int otherIndex )
+    {
+        const PeerList& peers = UnitPeers[index];
+        for( int i = 0; i < peers.count; i++ )
+        {
+            if( peers.cells[i] == otherIndex )
+                return true;
+        }
+        return false;
+    }
+}
+
+DancingLinksSolver::DancingLinksSolver( const SudokuBoard& sudokuBoard )
+: _sudokuBoard( sudokuBoard )
+, _nodes( nullptr )
+, _nodeCount( 0 )
+, _columnSizes( nullptr )
+, _solutionRowCount( 0 )
+{
+
+}
+
+void DancingLinksSolver::SetBoard( const SudokuBoard& sudokuBoard )
+{
+    _sudokuBoard = sudokuBoard;
+}
+
+const SudokuBoard& DancingLinksSolver::Solve()
+{
+    if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid() )
+        return _sudokuBoard;
+
+    ScratchScope scope;
+    bool isSolved = BuildMatrix( scope.GetArena() ) && Search();
+    _nodes = nullptr;
+    _columnSizes = nullptr;
+    if( !isSolved )
+        return _sudokuBoard;
+
+    for( int i = 0; i < _solutionRowCount; i++ )
+    {
+        int row = _solutionRows[i];
+        int index = row / 9;
+        if( !_sudokuBoard.SetAtChecked( index / 9, index % 9, row % 9 + 1 ) )
+        {
+            assert(false);
+        }
+    }
+
+    return _sudokuBoard;
+}
+
+bool DancingLinksSolver::DidSolvePuzzle() const
+{
+    return _sudokuBoard.IsBoardSolved();
+}
+
+const SudokuBoard& DancingLinksSolver::GetBoardSolving() const
+{
+    return _sudokuBoard;
+}
+
+bool DancingLinksSolver::BuildMatrix( ScratchArena& arena )
+{
+    _nodes = arena.Allocate<Node>( MaxNodeCount );
+    _columnSizes = arena.Allocate<int>( 1 + MaxColumnCount );
+    _nodeCount = 1;
+    _solutionRowCount = 0;
+
+    _nodes[Root] = Node{ Root, Root, Root, Root, Root, -1 };
+    _columnSizes[Root] = 0;
+
+    //Only constraints not already met by the placed values are linked in as primary columns
+    uint16_t rowMasks[9] = {}, colMasks[9] = {}, gridMasks[9] = {};
+    for( int index = 0; index < 9*9; index++ )
+    {
+        int value = _sudokuBoard.GetAt( index / 9, index % 9 );
+        if( value == 0 )
+            continue;
+
+        rowMasks[index / 9] |= CandidateBit( value );
+        colMasks[index % 9] |= CandidateBit( value );
+        gridMasks[GridIndexOf( index / 9, index % 9 )] |= CandidateBit( value );
+    }
+
+    for( int column = 0; column < PrimaryColumnCount; column++ )
+    {
+        int unit = column % 81;
+        int value = unit % 9 + 1;
+        bool isMet = false;
+        switch( column / 81 )
+        {
+            case 0: isMet = _sudokuBoard.GetAt( unit / 9, unit % 9 ) != 0; break;
+            case 1: isMet = ( rowMasks[unit / 9] & CandidateBit( value ) ) != 0; break;
+            case 2: isMet = ( colMasks[unit / 9] & CandidateBit( value ) ) != 0; break;
+            case 3: isMet = ( gridMasks[unit / 9] & CandidateBit( value ) ) != 0; break;
+        }
+        AddColumn( !isMet );
+    }
+
+    BoardType boardType = _sudokuBoard.GetBoardType();
+
+    //The secondary columns hold two spots that cannot both have the value; for a QueenSudoku one
+    //column per diagonal holds every spot that could still be a 9
+    int queenDiagonalColumns[2][17];
+    if( boardType == QueenSudoku )
+    {
+        for( int diagonal = 0; diagonal < 17; diagonal++ )
+        {
+            queenDiagonalColumns[0][diagonal] = AddColumn( false );
+            queenDiagonalColumns[1][diagonal] = AddColumn( false );
+        }
+    }
+
+    int* pairColumns = nullptr;
+    if( boardType == KnightSudoku || boardType == KingSudoku )
+    {
+        //Column of the pair (index, i'th variant peer, value); -1 when not needed
+        pairColumns = arena.Allocate<int>( 9*9*8*9 );
+        std::fill( pairColumns, pairColumns + 9*9*8*9, -1 );
+        for( int index = 0; index < 9*9; index++ )
+        {
+            uint16_t candidates = _sudokuBoard.GetCandidates( index / 9, index % 9 );
+            const PeerList& peers = VariantPeers[boardType][index];
+            for( int i = 0; i < peers.count; i++ )
+            {
+                int peer = peers.cells[i];
+                if( peer < index || ShareUnit( index, peer ) )
+                    continue;
+
+                uint16_t shared = candidates & _sudokuBoard.GetCandidates( peer / 9, peer % 9 );
+                if( shared == 0 )
+                    continue;
+
+                const PeerList& peersOfPeer = VariantPeers[boardType][peer];
+                int j = 0;
+                while( peersOfPeer.cells[j] != index )
+                    j++;
+
+                for( int value = 1; value <= 9; value++ )
+                {
+                    if( !( shared & CandidateBit( value ) ) )
+                        continue;
+
+                    int column = AddColumn( false );
+                    pairColumns[( index*8 + i )*9 + value - 1] = column;
+                    pairColumns[( peer*8 + j )*9 + value - 1] = column;
+                }
+            }
+        }
+    }
+
+    for( int index = 0; index < 9*9; index++ )
+    {
+        int row = index / 9;
+        int col = index % 9;
+        uint16_t candidates = _sudokuBoard.GetCandidates( row, col );
+        if( _sudokuBoard.GetAt( row, col ) != 0 )
+            continue;
+
+        //An empty spot without candidates means there is no solution
+        if( candidates == 0 )
+            return false;
+
+        for( int value = 1; value <= 9; value++ )
+        {
+            if( !( candidates & CandidateBit( value ) ) )
+                continue;
+
+            int columns[MaxColumnsPerRow];
+            int columnCount = 0;
+            columns[columnCount++] = 1 + SpotColumns + index;
+            columns[columnCount++] = 1 + RowColumns + row*9 + value - 1;
+            columns[columnCount++] = 1 + ColColumns + col*9 + value - 1;
+            columns[columnCount++] = 1 + GridColumns + GridIndexOf( row, col )*9 + value - 1;
+
+            if( boardType == QueenSudoku && value == 9 )
+            {
+                columns[columnCount++] = queenDiagonalColumns[0][row - col + 8];
+                columns[columnCount++] = queenDiagonalColumns[1][row + col];
+            }
+            else if( pairColumns != nullptr )
+            {
+                for( int i = 0; i < VariantPeers[boardType][index].count; i++ )
+                {
+                    int column = pairColumns[( index*8 + i )*9 + value - 1];
+                    if( column >= 0 )
+                        columns[columnCount++] = column;
+                }
+            }
+
+            AddRow( index*9 + value - 1, columns, columnCount );
+        }
+    }
+
+    return true;
+}
+
+int DancingLinksSolver::AddColumn( bool isPrimary )
+{
+    int column = _nodeCount++;
+    Node header{ column, column, column, column, column, -1 };
+
+    //Secondary columns stay out of the root's list so Search never has to cover them
+    if( isPrimary )
+    {
+        header.left = _nodes[Root].left;
+        header.right = Root;
+        _nodes[_nodes[Root].left].right = column;
+        _nodes[Root].left = column;
+    }
+
+    _nodes[column] = header;
+    _columnSizes[column] = 0;
+    return column;
+}
+
+void DancingLinksSolver::AddRow( int row, const int* columns, int columnCount )
+{
+    int first = _nodeCount;
+    for( int i = 0; i < columnCount; i++ )
+    {
+        int column = columns[i];
+        int node = first + i;
+
+        Node newNode;
+        newNode.left = i == 0 ? first + columnCount - 1 : node - 1;
+        newNode.right = i == columnCount - 1 ? first : node + 1;
+        newNode.up = _nodes[column].up;
+        newNode.down = column;
+        newNode.column = column;
+        newNode.row = row;
+
+        _nodes[_nodes[column].up].down = node;
+        _nodes[column].up = node;
+        _nodes[_nodeCount++] = newNode;
+        _columnSizes[column]++;
+    }
+}
+
+void DancingLinksSolver::Cover( int column )
+{
+    _nodes[_nodes[column].right].left = _nodes[column].left;
+    _nodes[_nodes[column].left].right = _nodes[column].right;
+
+    for( int i = _nodes[column].down; i != column; i = _nodes[i].down )
+    {
+        for( int j = _nodes[i].right; j != i; j = _nodes[j].right )
+        {
+            _nodes[_nodes[j].down].up = _nodes[j].up;
+            _nodes[_nodes[j].up].down = _nodes[j].down;
+            _columnSizes[_nodes[j].column]--;
+        }
+    }
+}
+
+void DancingLinksSolver::Uncover( int column )
+{
+    for( int i = _nodes[column].up; i != column; i = _nodes[i].up )
+    {
+        for( int j = _nodes[i].left; j != i; j = _nodes[j].left )
+        {
+            _columnSizes[_nodes[j].column]++;
+            _nodes[_nodes[j].down].up = j;
+            _nodes[_nodes[j].up].down = j;
+        }
+    }
+
+    _nodes[_nodes[column].right].left = column;
+    _nodes[_nodes[column].left].right = column;
+}
+
+bool DancingLinksSolver::Search()
+{
+    if( _nodes[Root].right == Root )
+        return true;
+
+    //Column with the fewest rows left
+    int column = _nodes[Root].right;
+    for( int c = _nodes[column].right; c != Root; c = _nodes[c].right )
+    {
+        if( _columnSizes[c] < _columnSizes[column] )
+            column = c;
+    }
+
+    if( _columnSizes[column] == 0 )
+        return false;
+
+    Cover( column );
+    for( int i = _nodes[column].down; i != column; i = _nodes[i].down )
+    {
+        _solutionRows[_solutionRowCount++] = _nodes[i].row;
+        for( int j = _nodes[i].right; j != i; j = _nodes[j].right )
+        {
+            Cover( _nodes[j].column );
+        }
+
+        if( Search() )
+            return true;
+
+        for( int j = _nodes[i].left; j != i; j = _nodes[j].left )
+        {
+            Uncover( _nodes[j].column );
+        }
+        _solutionRowCount--;
+    }
+    Uncover( column );
+
+    return false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <array>
+
+class ScratchArena;
+
+//Solves a board as an exact cover problem with Knuth's Dancing Links (Algorithm X).
+//
+//Every empty spot/candidate value is a row of the matrix and the primary columns are the usual
+//four Sudoku constraints (spot filled, value once per row, per column and per 3x3 grid).  The
+//knight/king/queen rules are "at most once" constraints so they become secondary columns which
+//may be left uncovered.
+class DancingLinksSolver
+{
+public:
+   DancingLinksSolver( const SudokuBoard& sudokuBoard );
+
+   //Starts over on another board
+   void SetBoard( const SudokuBoard& sudokuBoard );
+
+   //Check DidSolvePuzzle() for whether it worked
+   const SudokuBoard& Solve();
+
+   bool DidSolvePuzzle() const;
+
+   const SudokuBoard& GetBoardSolving() const;
+
+private:
+   struct Node
+   {
+      int left, right, up, down;
+      int column;
+      int row;//index*9 + value-1 of the placement this node belongs to
+   };
+
+   bool BuildMatrix( ScratchArena& arena );
+   int AddColumn( bool isPrimary );
+   void AddRow( int row, const int* columns, int columnCount );
+   void Cover( int column );
+   void Uncover( int column );
+   bool Search();
+
+   SudokuBoard _sudokuBoard;
+
+   //Only there while Solve runs, from the thread's ScratchArena.  Node 0 is the root, then the
+   //column headers, then the nodes of the rows.
+   Node* _nodes;
+   int _nodeCount;
+   int* _columnSizes;
+
+   std::array<int, 9*9> _solutionRows;
+   int _solutionRowCount;
+};
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "ScratchArena.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+//Grids bigger than 9x9 write 10 and up as letters: A for 10 up to P for 25.  '0' and '.' are an
+//empty spot.  Returns -1 for anything else.
+inline int GridValueFromChar( char ch )
+{
+   if( ch == '0' || ch == '.' )
+      return 0;
+   if( ch >= '1' && ch <= '9' )
+      return ch - '0';
+   if( ch >= 'A' && ch <= 'Z' )
+      return ch - 'A' + 10;
+   if( ch >= 'a' && ch <= 'z' )
+      return ch - 'a' + 10;
+   return -1;
+}
+
+inline char GridCharFromValue( int value )
+{
+   if( value == 0 )
+      return '.';
+   return static_cast<char>( value <= 9 ? '0' + value : 'A' + value - 10 );
+}
+
+namespace GridBoardDetail
+{
+   //Units 0 to size-1 are the rows, then the columns, then the boxes, each listing its spots
+   template<int BoxRows, int BoxCols, typename Spot>
+   constexpr std::array<std::array<Spot, BoxRows*BoxCols>, 3*BoxRows*BoxCols> MakeUnits()
+   {
+      constexpr int Size = BoxRows*BoxCols;
+      std::array<std::array<Spot, Size>, 3*Size> units{};
+      for( int i = 0; i < Size; i++ )
+      {
+         //Boxes are numbered across then down, BoxRows of them across the grid
+         int boxRow = ( i / BoxRows ) * BoxRows;
+         int boxCol = ( i % BoxRows ) * BoxCols;
+         for( int j = 0; j < Size; j++ )
+         {
+            units[i][j] = static_cast<Spot>( i*Size + j );
+            units[Size + i][j] = static_cast<Spot>( j*Size + i );
+            units[2*Size + i][j] = static_cast<Spot>( ( boxRow + j / BoxCols ) * Size + boxCol + j % BoxCols );
+         }
+      }
+      return units;
+   }
+}
+
+//A Traditional puzzle on a grid of BoxRows x BoxCols boxes, so 4x4 is GridBoard<2, 2>, 6x6 is
+//GridBoard<2, 3> and 16x16 is GridBoard<4, 4>.  SudokuBoard stays the board for 9x9 puzzles with
+//its variants; this one only keeps what a search needs: the values placed in each row, column and
+//box and the candidates ruled out of each spot, from which its candidates are worked out when asked
+//for.  Its trail comes from the thread's ScratchArena, so it has to be made in a ScratchScope,
+//is only good until that scope ends and cannot be copied.
+template<int BoxRows, int BoxCols>
+class GridBoard
+{
+public:
+   static constexpr int Size = BoxRows*BoxCols;
+   static constexpr int SpotCount = Size*Size;
+   static constexpr int UnitCount = 3*Size;
+
+   //Bit value-1 is set when value is a candidate
+   typedef typename std::conditional<Size <= 16, uint16_t, uint32_t>::type Mask;
+   static constexpr Mask AllCandidates = static_cast<Mask>( ( uint64_t( 1 ) << Size ) - 1 );
+
+   //Spots are numbered row*Size + col
+   typedef typename std::conditional<SpotCount <= 256, uint8_t, uint16_t>::type Spot;
+   typedef std::array<std::array<Spot, Size>, UnitCount> UnitTable;
+   static constexpr UnitTable Units = GridBoardDetail::MakeUnits<BoxRows, BoxCols, Spot>();
+
+   static_assert( Size >= 2 && Size <= 32, "Candidates have to fit in a 32 bit mask" );
+
+   //One character per spot, row by row, as GridValueFromChar reads them.  Characters that are not
+   //values leave the spot empty.
+   explicit GridBoard( const std::string& placements );
+
+   GridBoard( const GridBoard& ) = delete;
+   GridBoard& operator=( const GridBoard& ) = delete;
+
+   int GetAt( int row, int col ) const { return _placements[row*Size + col]; }
+
+   //Values that could still be placed at an empty spot; 0 for spots already filled
+   Mask GetCandidates( int row, int col ) const;
+   bool IsPlacementLegal( int row, int col, int value ) const;
+
+   //Rules candidates out of an empty spot; returns whether any were there
+   bool EliminateCandidates( int row, int col, Mask candidates );
+
+   //Same as SudokuBoard: Place puts a value on an empty spot where it is legal and Undo takes back
+   //the most recent Place or EliminateCandidates
+   void Place( int row, int col, int value );
+   void Undo();
+   void UndoTo( int trailSize );
+   int GetTrailSize() const { return _trailSize; }
+
+   //Only the givens can conflict since Place never breaks the rules
+   bool IsBoardValid() const { return _conflicts == 0; }
+   bool IsBoardSolved() const { return _emptySpots == 0; }
+
+   static constexpr int BoxIndexOf( int row, int col ) { return ( row / BoxRows ) * BoxRows + col / BoxCols; }
+
+   //Sets text to the placements in the format the constructor reads
+   void GetPlacements( std::string& text ) const;
+
+private:
+   void AddToUnits( int index, int value );
+
+   //Values already placed in each row/col/box
+   std::array<Mask, Size> _rowMasks;
+   std::array<Mask, Size> _colMasks;
+   std::array<Mask, Size> _boxMasks;
+
+   std::array<uint8_t, SpotCount> _placements;
+   std::array<Mask, SpotCount> _eliminated;
+
+   //A Place when eliminated is 0, otherwise the candidates EliminateCandidates took out
+   struct TrailEntry
+   {
+      Spot spot;
+      Mask eliminated;
+   };
+
+   //A spot is placed at most once and each of its candidates ruled out at most once before they
+   //are undone, so the trail never gets longer than this
+   static constexpr int MaxTrailSize = SpotCount*( Size + 1 );
+
+   //Most recent last
+   TrailEntry* _trail;
+   int _trailSize;
+
+   int _emptySpots;
+   int _conflicts;
+};
+
+template<int BoxRows, int BoxCols>
+GridBoard<BoxRows, BoxCols>::GridBoard( const std::string& placements )
+: _trail( ScratchArena::ForThisThread().Allocate<TrailEntry>( MaxTrailSize ) )
+, _trailSize( 0 )
+, _emptySpots( SpotCount )
+, _conflicts( 0 )
+{
+   _rowMasks.fill( 0 );
+   _colMasks.fill( 0 );
+   _boxMasks.fill( 0 );
+   _placements.fill( 0 );
+   _eliminated.fill( 0 );
+
+   for( int index = 0; index < SpotCount && index < static_cast<int>( placements.size() ); index++ )
+   {
+      int value = GridValueFromChar( placements[index] );
+      if( value <= 0 || value > Size )
+         continue;
+
+      if( !IsPlacementLegal( index / Size, index % Size, value ) )
+         _conflicts++;
+
+      _placements[index] = static_cast<uint8_t>( value );
+      _emptySpots--;
+      AddToUnits( index, value );
+   }
+}
+
+template<int BoxRows, int BoxCols>
+typename GridBoard<BoxRows, BoxCols>::Mask GridBoard<BoxRows, BoxCols>::GetCandidates( int row, int col ) const
+{
+   if( _placements[row*Size + col] != 0 )
+      return 0;
+
+   return AllCandidates & ~( _rowMasks[row] | _colMasks[col] | _boxMasks[BoxIndexOf( row, col )] | _eliminated[row*Size + col] );
+}
+
+template<int BoxRows, int BoxCols>
+bool GridBoard<BoxRows, BoxCols>::IsPlacementLegal( int row, int col, int value ) const
+{
+   Mask bit = static_cast<Mask>( Mask( 1 ) << ( value - 1 ) );
+   return !( ( _rowMasks[row] | _colMasks[col] | _boxMasks[BoxIndexOf( row, col )] ) & bit );
+}
+
+template<int BoxRows, int BoxCols>
+void GridBoard<BoxRows, BoxCols>::Place( int row, int col, int value )
+{
+   int index = row*Size + col;
+   assert( _placements[index] == 0 && IsPlacementLegal( row, col, value ) );
+
+   _placements[index] = static_cast<uint8_t>( value );
+   _emptySpots--;
+   AddToUnits( index, value );
+   assert( _trailSize < MaxTrailSize );
+   _trail[_trailSize++] = TrailEntry{ static_cast<Spot>( index ), 0 };
+}
+
+template<int BoxRows, int BoxCols>
+bool GridBoard<BoxRows, BoxCols>::EliminateCandidates( int row, int col, Mask candidates )
+{
+   Mask removed = GetCandidates( row, col ) & candidates;
+   if( removed == 0 )
+      return false;
+
+   int index = row*Size + col;
+   _eliminated[index] |= removed;
+   assert( _trailSize < MaxTrailSize );
+   _trail[_trailSize++] = TrailEntry{ static_cast<Spot>( index ), removed };
+   return true;
+}
+
+template<int BoxRows, int BoxCols>
+void GridBoard<BoxRows, BoxCols>::Undo()
+{
+   assert( _trailSize > 0 );
+
+   TrailEntry entry = _trail[--_trailSize];
+
+   int index = entry.spot;
+   if( entry.eliminated != 0 )
+   {
+      _eliminated[index] &= ~entry.eliminated;
+      return;
+   }
+
+   int row = index / Size;
+   int col = index % Size;
+   Mask keep = static_cast<Mask>( ~( Mask( 1 ) << ( _placements[index] - 1 ) ) );
+   _rowMasks[row] &= keep;
+   _colMasks[col] &= keep;
+   _boxMasks[BoxIndexOf( row, col )] &= keep;
+   _placements[index] = 0;
+   _emptySpots++;
+}
+
+template<int BoxRows, int BoxCols>
+void GridBoard<BoxRows, BoxCols>::UndoTo( int trailSize )
+{
+   while( _trailSize > trailSize )
+   {
+      Undo();
+   }
+}
+
+template<int BoxRows, int BoxCols>
+void GridBoard<BoxRows, BoxCols>::GetPlacements( std::string& text ) const
+{
+   text.resize( SpotCount );
+   for( int index = 0; index < SpotCount; index++ )
+   {
+      text[index] = GridCharFromValue( _placements[index] );
+   }
+}
+
+template<int BoxRows, int BoxCols>
+void GridBoard<BoxRows, BoxCols>::AddToUnits( int index, int value )
+{
+   int row = index / Size;
+   int col = index % Size;
+   Mask bit = static_cast<Mask>( Mask( 1 ) << ( value - 1 ) );
+   _rowMasks[row] |= bit;
+   _colMasks[col] |= bit;
+   _boxMasks[BoxIndexOf( row, col )] |= bit;
+}
+
+template<int BoxRows, int BoxCols>
+std::ostream& operator<<( std::ostream& os, const GridBoard<BoxRows, BoxCols>& gridBoard )
+{
+   const int Size = BoxRows*BoxCols;
+   for( int row = 0; row < Size; row++ )
+   {
+      if( row != 0 && row % BoxRows == 0 )
+         os << std::string( Size + BoxRows - 1, '-' ) << std::endl;
+
+      for( int col = 0; col < Size; col++ )
+      {
+         if( col != 0 && col % BoxCols == 0 )
+            os << '|';
+
+         int value = gridBoard.GetAt( row, col );
+         os << ( value == 0 ? '-' : GridCharFromValue( value ) );
+      }
+      os << std::endl;
+   }
+   return os;
+}
\ No newline at end of file
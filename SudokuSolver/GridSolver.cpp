@@ -0,0 +1,58 @@
+#include "GridSolver.h"
+
+#include "ScratchArena.h"
+
+#include <chrono>
+
+namespace
+{
+    template<int BoxRows, int BoxCols>
+    bool SolveGrid( const std::string& placements, std::string& solution, SolveStats* stats )
+    {
+        typedef GridBoard<BoxRows, BoxCols> Board;
+
+        for( char ch : placements )
+        {
+            int value = GridValueFromChar( ch );
+            if( value < 0 || value > Board::Size )
+                return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ScratchScope scope;
+        uint64_t heapAllocations = scope.GetArena().GetHeapAllocations();
+        GridSolver<BoxRows, BoxCols> solver( placements );
+        solver.Solve();
+        if( stats != nullptr )
+        {
+            stats->Add( solver.GetStats() );
+            stats->searchSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            stats->scratchAllocations += scope.GetArena().GetHeapAllocations() - heapAllocations;
+        }
+
+        if( solver.DidSolvePuzzle() )
+            solver.GetBoardSolving().GetPlacements( solution );
+        else
+            solution.clear();
+        return true;
+    }
+}
+
+bool SolveGridPuzzle( const std::string& placements, std::string& solution, SolveStats* stats /*= nullptr*/ )
+{
+    switch( placements.size() )
+    {
+        case 4*4:
+            return SolveGrid<2, 2>( placements, solution, stats );
+        case 6*6:
+            return SolveGrid<2, 3>( placements, solution, stats );
+        case 9*9:
+            return SolveGrid<3, 3>( placements, solution, stats );
+        case 16*16:
+            return SolveGrid<4, 4>( placements, solution, stats );
+        case 25*25:
+            return SolveGrid<5, 5>( placements, solution, stats );
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+#pragma once
+
+#include "GridBoard.h"
+#include "PeerTables.h"
+#include "SudokuSolver.h"
+
+#include <algorithm>
+#include <string>
+
+//Solves a GridBoard the way SudokuSolver::Solve does a 9x9 board: a depth first search that
+//places naked and hidden singles after every guess.  It guesses at the spot with the fewest
+//candidates or, when that is fewer choices, at the spots left for a value in a unit.
+template<int BoxRows, int BoxCols>
+class GridSolver
+{
+public:
+   typedef GridBoard<BoxRows, BoxCols> Board;
+   typedef typename Board::Mask Mask;
+
+   //Makes the board from placements the way GridBoard does, so in a ScratchScope too
+   explicit GridSolver( const std::string& placements );
+
+   //Check DidSolvePuzzle() for whether it worked
+   const Board& Solve();
+
+   bool DidSolvePuzzle() const { return _gridBoard.IsBoardSolved(); }
+   const Board& GetBoardSolving() const { return _gridBoard; }
+
+   //Only the search counters are used
+   const SolveStats& GetStats() const { return _stats; }
+
+private:
+   bool Search();
+   bool PropagateSingles();
+   bool EliminateLockedCandidates();
+   int EliminateOutside( int unitIndex, Mask candidates, int keptUnitIndex );
+   int FindSpotWithFewestCandidates() const;
+   void FindValueWithFewestSpots( int fewestSpots, int& unitIndex, int& value ) const;
+   bool TryGuess( int row, int col, int value );
+
+   Board _gridBoard;
+   SolveStats _stats;
+   int _guessDepth;
+};
+
+//Solves a Traditional 4x4, 6x6, 9x9, 16x16 or 25x25 puzzle written one character per spot as
+//GridBoard reads them, picking the grid from the length.  Returns false if placements is not
+//such a puzzle; otherwise solution is the solved values or empty when there is no solution.
+bool SolveGridPuzzle( const std::string& placements, std::string& solution, SolveStats* stats = nullptr );
+
+template<int BoxRows, int BoxCols>
+GridSolver<BoxRows, BoxCols>::GridSolver( const std::string& placements )
+: _gridBoard( placements )
+, _guessDepth( 0 )
+{
+}
+
+template<int BoxRows, int BoxCols>
+const typename GridSolver<BoxRows, BoxCols>::Board& GridSolver<BoxRows, BoxCols>::Solve()
+{
+   if( _gridBoard.IsBoardValid() )
+      Search();
+   return _gridBoard;
+}
+
+template<int BoxRows, int BoxCols>
+bool GridSolver<BoxRows, BoxCols>::Search()
+{
+   int trailSize = _gridBoard.GetTrailSize();
+
+   if( !PropagateSingles() )
+   {
+      _gridBoard.UndoTo( trailSize );
+      return false;
+   }
+
+   int index = FindSpotWithFewestCandidates();
+   if( index < 0 )
+      return true;
+
+   //On big grids a value with only a few spots left in a unit often has fewer choices than the
+   //best spot, so guess whichever has fewer
+   int row = index / Board::Size;
+   int col = index % Board::Size;
+   int unitIndex = -1;
+   int value = 0;
+   FindValueWithFewestSpots( CountBits( _gridBoard.GetCandidates( row, col ) ), unitIndex, value );
+
+   _guessDepth++;
+   _stats.maxGuessDepth = std::max( _stats.maxGuessDepth, _guessDepth );
+   bool isSolved = false;
+   if( unitIndex < 0 )
+   {
+      for( Mask candidates = _gridBoard.GetCandidates( row, col ); candidates != 0 && !isSolved; candidates &= candidates - 1 )
+      {
+         isSolved = TryGuess( row, col, FindLowestBit( candidates ) + 1 );
+      }
+   }
+   else
+   {
+      Mask bit = Mask( 1 ) << ( value - 1 );
+      for( int i = 0; i < Board::Size && !isSolved; i++ )
+      {
+         int spot = Board::Units[unitIndex][i];
+         if( _gridBoard.GetCandidates( spot / Board::Size, spot % Board::Size ) & bit )
+            isSolved = TryGuess( spot / Board::Size, spot % Board::Size, value );
+      }
+   }
+   _guessDepth--;
+
+   if( !isSolved )
+      _gridBoard.UndoTo( trailSize );
+   return isSolved;
+}
+
+template<int BoxRows, int BoxCols>
+bool GridSolver<BoxRows, BoxCols>::TryGuess( int row, int col, int value )
+{
+   _gridBoard.Place( row, col, value );
+   _stats.guesses++;
+
+   if( Search() )
+      return true;
+
+   _gridBoard.Undo();
+   _stats.backtracks++;
+   return false;
+}
+
+//Places naked singles until there are none, then hidden singles, and goes round again until
+//neither places anything.  Returns false if a spot or a value of a unit has nowhere to go.
+template<int BoxRows, int BoxCols>
+bool GridSolver<BoxRows, BoxCols>::PropagateSingles()
+{
+   for( ;; )
+   {
+      bool placedAny = false;
+      for( int index = 0; index < Board::SpotCount; index++ )
+      {
+         int row = index / Board::Size;
+         int col = index % Board::Size;
+         if( _gridBoard.GetAt( row, col ) != 0 )
+            continue;
+
+         Mask candidates = _gridBoard.GetCandidates( row, col );
+         if( candidates == 0 )
+            return false;
+
+         if( ( candidates & ( candidates - 1 ) ) == 0 )
+         {
+            _gridBoard.Place( row, col, FindLowestBit( candidates ) + 1 );
+            _stats.searchSinglePlacements++;
+            placedAny = true;
+         }
+      }
+
+      if( placedAny )
+         continue;
+
+      for( const auto& unit : Board::Units )
+      {
+         Mask placed = 0, seenOnce = 0, seenMoreThanOnce = 0;
+         for( int spot : unit )
+         {
+            int value = _gridBoard.GetAt( spot / Board::Size, spot % Board::Size );
+            if( value != 0 )
+            {
+               placed |= Mask( 1 ) << ( value - 1 );
+               continue;
+            }
+
+            Mask candidates = _gridBoard.GetCandidates( spot / Board::Size, spot % Board::Size );
+            seenMoreThanOnce |= seenOnce & candidates;
+            seenOnce |= candidates;
+         }
+
+         if( ( placed | seenOnce ) != Board::AllCandidates )
+            return false;
+
+         Mask hiddenSingles = seenOnce & ~seenMoreThanOnce & ~placed;
+         if( hiddenSingles == 0 )
+            continue;
+
+         for( int spot : unit )
+         {
+            int row = spot / Board::Size;
+            int col = spot % Board::Size;
+            Mask candidates = _gridBoard.GetCandidates( row, col ) & hiddenSingles;
+            if( candidates == 0 )
+               continue;
+
+            //Two values that can only go in the same spot
+            if( CountBits( candidates ) > 1 )
+               return false;
+
+            _gridBoard.Place( row, col, FindLowestBit( candidates ) + 1 );
+            _stats.searchSinglePlacements++;
+            placedAny = true;
+         }
+      }
+
+      if( !placedAny && !EliminateLockedCandidates() )
+         return true;
+   }
+}
+
+//A value whose spots in a box are all on one row or column cannot go anywhere else on that row or
+//column, and the other way around.  Returns whether it ruled anything out.
+template<int BoxRows, int BoxCols>
+bool GridSolver<BoxRows, BoxCols>::EliminateLockedCandidates()
+{
+   //Where a row or a column crosses a box: the candidates of those spots.  A row crosses BoxRows
+   //boxes and a column BoxCols of them.
+   Mask rowSegments[Board::Size][BoxRows] = {};
+   Mask colSegments[Board::Size][BoxCols] = {};
+   for( int row = 0; row < Board::Size; row++ )
+   {
+      for( int col = 0; col < Board::Size; col++ )
+      {
+         Mask candidates = _gridBoard.GetCandidates( row, col );
+         rowSegments[row][col / BoxCols] |= candidates;
+         colSegments[col][row / BoxRows] |= candidates;
+      }
+   }
+
+   //The candidates only in segment i of segments
+   auto onlyIn = []( const Mask* segments, int count, int i )
+   {
+      Mask others = 0;
+      for( int j = 0; j < count; j++ )
+      {
+         if( j != i )
+            others |= segments[j];
+      }
+      return static_cast<Mask>( segments[i] & ~others );
+   };
+
+   const int Rows = 0, Cols = Board::Size, Boxes = 2*Board::Size;
+   int eliminated = 0;
+   for( int box = 0; box < Board::Size; box++ )
+   {
+      //The box's segments, taken from the rows and columns running through it
+      int boxRow = ( box / BoxRows ) * BoxRows;
+      int boxCol = ( box % BoxRows ) * BoxCols;
+      Mask boxRowSegments[BoxRows];
+      Mask boxColSegments[BoxCols];
+      for( int k = 0; k < BoxRows; k++ )
+      {
+         boxRowSegments[k] = rowSegments[boxRow + k][box % BoxRows];
+      }
+      for( int k = 0; k < BoxCols; k++ )
+      {
+         boxColSegments[k] = colSegments[boxCol + k][box / BoxRows];
+      }
+
+      for( int k = 0; k < BoxRows; k++ )
+      {
+         eliminated += EliminateOutside( Rows + boxRow + k, onlyIn( boxRowSegments, BoxRows, k ), Boxes + box );
+      }
+      for( int k = 0; k < BoxCols; k++ )
+      {
+         eliminated += EliminateOutside( Cols + boxCol + k, onlyIn( boxColSegments, BoxCols, k ), Boxes + box );
+      }
+   }
+
+   for( int line = 0; line < Board::Size; line++ )
+   {
+      for( int k = 0; k < BoxRows; k++ )
+      {
+         int box = ( line / BoxRows ) * BoxRows + k;
+         eliminated += EliminateOutside( Boxes + box, onlyIn( rowSegments[line], BoxRows, k ), Rows + line );
+      }
+      for( int k = 0; k < BoxCols; k++ )
+      {
+         int box = k * BoxRows + line / BoxCols;
+         eliminated += EliminateOutside( Boxes + box, onlyIn( colSegments[line], BoxCols, k ), Cols + line );
+      }
+   }
+
+   return eliminated != 0;
+}
+
+//Rules candidates out of the spots of a unit that are not also in keptUnitIndex.  Returns how many
+//spots lost any.
+template<int BoxRows, int BoxCols>
+int GridSolver<BoxRows, BoxCols>::EliminateOutside( int unitIndex, Mask candidates, int keptUnitIndex )
+{
+   if( candidates == 0 )
+      return 0;
+
+   int eliminated = 0;
+   for( int spot : Board::Units[unitIndex] )
+   {
+      int row = spot / Board::Size;
+      int col = spot % Board::Size;
+      int unitsOfSpot[] = { row, Board::Size + col, 2*Board::Size + Board::BoxIndexOf( row, col ) };
+      if( unitsOfSpot[0] == keptUnitIndex || unitsOfSpot[1] == keptUnitIndex || unitsOfSpot[2] == keptUnitIndex )
+         continue;
+
+      if( _gridBoard.EliminateCandidates( row, col, candidates ) )
+         eliminated++;
+   }
+   return eliminated;
+}
+
+//The empty spot with the fewest candidates or -1 if the board is full
+template<int BoxRows, int BoxCols>
+int GridSolver<BoxRows, BoxCols>::FindSpotWithFewestCandidates() const
+{
+   int bestIndex = -1;
+   int bestCount = Board::Size + 1;
+   for( int index = 0; index < Board::SpotCount; index++ )
+   {
+      if( _gridBoard.GetAt( index / Board::Size, index % Board::Size ) != 0 )
+         continue;
+
+      int count = CountBits( _gridBoard.GetCandidates( index / Board::Size, index % Board::Size ) );
+      if( count < bestCount )
+      {
+         bestIndex = index;
+         bestCount = count;
+         if( count <= 2 )
+            break;
+      }
+   }
+   return bestIndex;
+}
+
+//The unit and value with fewer than fewestSpots spots left for it, the fewest of them all.  Leaves
+//unitIndex alone if there is none.
+template<int BoxRows, int BoxCols>
+void GridSolver<BoxRows, BoxCols>::FindValueWithFewestSpots( int fewestSpots, int& unitIndex, int& value ) const
+{
+   for( int unit = 0; unit < Board::UnitCount && fewestSpots > 2; unit++ )
+   {
+      //Spots left for each value in the unit
+      int counts[Board::Size] = {};
+      for( int spot : Board::Units[unit] )
+      {
+         for( Mask candidates = _gridBoard.GetCandidates( spot / Board::Size, spot % Board::Size ); candidates != 0; candidates &= candidates - 1 )
+         {
+            counts[FindLowestBit( candidates )]++;
+         }
+      }
+
+      for( int i = 0; i < Board::Size; i++ )
+      {
+         if( counts[i] > 0 && counts[i] < fewestSpots )
+         {
+            fewestSpots = counts[i];
+            unitIndex = unit;
+            value = i + 1;
+         }
+      }
+   }
+}
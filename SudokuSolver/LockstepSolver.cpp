@@ -0,0 +1,235 @@
+#include "LockstepSolver.h"
+
+#include "BoardKernels.h"
+#include "PeerTables.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    //A value's bit per spot and lane: placed has the bit of the value at filled spots, candidates
+    //the candidates of the empty ones, so every lane is a board laid out like SudokuBoard's masks
+    struct LockstepBoards
+    {
+        alignas( 32 ) uint16_t placed[9*9][LockstepLaneCount];
+        alignas( 32 ) uint16_t candidates[9*9][LockstepLaneCount];
+        //Set by PropagateLockstep: the values of placed as 0 to 9 and the lanes that turned out to
+        //have no solution or were filled
+        alignas( 32 ) uint16_t values[9*9][LockstepLaneCount];
+        alignas( 32 ) uint16_t noSolution[LockstepLaneCount];
+        alignas( 32 ) uint16_t filled[LockstepLaneCount];
+    };
+
+    void SolveOnItsOwn( SudokuBoard& sudokuBoard, SolveStats* stats )
+    {
+        SudokuSolver solver( sudokuBoard );
+        solver.Solve();
+        if( solver.DidSolvePuzzle() )
+            sudokuBoard = solver.GetBoardSolving();
+        if( stats != nullptr )
+            stats->Add( solver.GetStats() );
+    }
+
+#if defined(SUDOKU_X86_KERNELS)
+    //Each pass takes the values placed so far out of their peers' candidates and places the naked
+    //singles as it goes, then places the hidden singles of every unit.  All of them are forced so a
+    //lane that places a value twice among peers, or is left with a spot or a unit value that cannot
+    //be filled, has no solution.  The values in each unit are kept up to date as they are placed
+    //but a spot's candidates only lose them when the next pass gets to it; until then they are only
+    //more candidates than there really are, which can hide a single but never make a wrong one.
+    //Stops once a pass places nothing on any lane that can still be solved.
+    SUDOKU_TARGET( "avx2" ) void PropagateLockstep( LockstepBoards& boards, BoardType boardType )
+    {
+        __m256i* placed = reinterpret_cast<__m256i*>( boards.placed );
+        __m256i* candidates = reinterpret_cast<__m256i*>( boards.candidates );
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi16( 1 );
+        const __m256i allCandidates = _mm256_set1_epi16( AllCandidates );
+        //Only the 9s see along a queen's diagonals
+        const __m256i variantValues = _mm256_set1_epi16( VariantPeersConstrain( boardType, 1 ) ? AllCandidates : CandidateBit( 9 ) );
+        const PeerTable& variantPeers = VariantPeers[boardType];
+
+        //Any bit set in a lane means it has no solution
+        __m256i contradictions = zero;
+        __m256i unitPlaced[3*9];
+        for( int unitIndex = 0; unitIndex < 3*9; unitIndex++ )
+        {
+            __m256i seen = zero;
+            for( uint8_t spot : Units[unitIndex] )
+            {
+                contradictions = _mm256_or_si256( contradictions, _mm256_and_si256( seen, placed[spot] ) );
+                seen = _mm256_or_si256( seen, placed[spot] );
+            }
+            unitPlaced[unitIndex] = seen;
+        }
+
+        for( ;; )
+        {
+            __m256i changed = zero;
+            for( int spot = 0; spot < 9*9; spot++ )
+            {
+                __m256i* spotUnits[] = { &unitPlaced[spot / 9], &unitPlaced[9 + spot % 9], &unitPlaced[18 + GridIndexOf( spot / 9, spot % 9 )] };
+                __m256i seenByPeers = _mm256_or_si256( *spotUnits[0], _mm256_or_si256( *spotUnits[1], *spotUnits[2] ) );
+
+                const PeerList& peers = variantPeers[spot];
+                __m256i seenByVariantPeers = zero;
+                for( int i = 0; i < peers.count; i++ )
+                    seenByVariantPeers = _mm256_or_si256( seenByVariantPeers, placed[peers.cells[i]] );
+                seenByVariantPeers = _mm256_and_si256( seenByVariantPeers, variantValues );
+                contradictions = _mm256_or_si256( contradictions, _mm256_and_si256( seenByVariantPeers, placed[spot] ) );
+
+                __m256i spotCandidates = _mm256_andnot_si256( _mm256_or_si256( seenByPeers, seenByVariantPeers ), candidates[spot] );
+                __m256i isEmpty = _mm256_cmpeq_epi16( placed[spot], zero );
+                __m256i hasNone = _mm256_cmpeq_epi16( spotCandidates, zero );
+                contradictions = _mm256_or_si256( contradictions, _mm256_and_si256( isEmpty, hasNone ) );
+
+                //Not in any of the spot's units yet, so only needs adding to them
+                __m256i isSingle = _mm256_andnot_si256( hasNone, _mm256_cmpeq_epi16( _mm256_and_si256( spotCandidates, _mm256_sub_epi16( spotCandidates, one ) ), zero ) );
+                __m256i single = _mm256_and_si256( spotCandidates, isSingle );
+                placed[spot] = _mm256_or_si256( placed[spot], single );
+                candidates[spot] = _mm256_andnot_si256( isSingle, spotCandidates );
+                for( __m256i* unitValues : spotUnits )
+                    *unitValues = _mm256_or_si256( *unitValues, single );
+                changed = _mm256_or_si256( changed, single );
+            }
+
+            for( int unitIndex = 0; unitIndex < 3*9; unitIndex++ )
+            {
+                __m256i once = zero;
+                __m256i twice = zero;
+                for( uint8_t spot : Units[unitIndex] )
+                {
+                    twice = _mm256_or_si256( twice, _mm256_and_si256( once, candidates[spot] ) );
+                    once = _mm256_or_si256( once, candidates[spot] );
+                }
+                __m256i have = unitPlaced[unitIndex];
+                contradictions = _mm256_or_si256( contradictions, _mm256_andnot_si256( _mm256_or_si256( once, have ), allCandidates ) );
+
+                __m256i hiddenSingles = _mm256_andnot_si256( _mm256_or_si256( twice, have ), once );
+                if( _mm256_testz_si256( hiddenSingles, hiddenSingles ) )
+                    continue;
+
+                for( uint8_t spot : Units[unitIndex] )
+                {
+                    __m256i single = _mm256_and_si256( candidates[spot], hiddenSingles );
+                    //Two values that can only go in the same spot
+                    contradictions = _mm256_or_si256( contradictions, _mm256_and_si256( single, _mm256_sub_epi16( single, one ) ) );
+                    placed[spot] = _mm256_or_si256( placed[spot], single );
+                    candidates[spot] = _mm256_and_si256( candidates[spot], _mm256_cmpeq_epi16( single, zero ) );
+
+                    //The other two units of the spot may already have it
+                    __m256i* spotUnits[] = { &unitPlaced[spot / 9], &unitPlaced[9 + spot % 9], &unitPlaced[18 + GridIndexOf( spot / 9, spot % 9 )] };
+                    for( __m256i* unitValues : spotUnits )
+                    {
+                        contradictions = _mm256_or_si256( contradictions, _mm256_and_si256( *unitValues, single ) );
+                        *unitValues = _mm256_or_si256( *unitValues, single );
+                    }
+                    changed = _mm256_or_si256( changed, single );
+                }
+            }
+
+            __m256i canBeSolved = _mm256_cmpeq_epi16( contradictions, zero );
+            if( _mm256_testz_si256( changed, canBeSolved ) )
+                break;
+        }
+
+        __m256i filled = _mm256_cmpeq_epi16( zero, zero );
+        __m256i* values = reinterpret_cast<__m256i*>( boards.values );
+        for( int spot = 0; spot < 9*9; spot++ )
+        {
+            filled = _mm256_andnot_si256( _mm256_cmpeq_epi16( placed[spot], zero ), filled );
+
+            __m256i spotValues = zero;
+            for( int value = 1; value <= 9; value++ )
+            {
+                __m256i isValue = _mm256_cmpeq_epi16( placed[spot], _mm256_set1_epi16( CandidateBit( value ) ) );
+                spotValues = _mm256_or_si256( spotValues, _mm256_and_si256( isValue, _mm256_set1_epi16( value ) ) );
+            }
+            values[spot] = spotValues;
+        }
+
+        __m256i noSolution = _mm256_xor_si256( _mm256_cmpeq_epi16( contradictions, zero ), _mm256_cmpeq_epi16( zero, zero ) );
+        _mm256_store_si256( reinterpret_cast<__m256i*>( boards.noSolution ), noSolution );
+        _mm256_store_si256( reinterpret_cast<__m256i*>( boards.filled ), filled );
+    }
+
+    //Up to LockstepLaneCount boards of the same type, given by their index into boards.  Lanes
+    //past the last board repeat it so they need no masking.
+    void SolveLockstepGroup( SudokuBoard* boards, const size_t* group, int groupSize, BoardType boardType, SolveStats* stats, LockstepBoards& lanes )
+    {
+        for( int lane = 0; lane < LockstepLaneCount; lane++ )
+        {
+            const SudokuBoard& sudokuBoard = boards[group[std::min( lane, groupSize - 1 )]];
+            for( int spot = 0; spot < 9*9; spot++ )
+            {
+                int value = sudokuBoard.GetAt( spot / 9, spot % 9 );
+                lanes.placed[spot][lane] = value != 0 ? CandidateBit( value ) : 0;
+                lanes.candidates[spot][lane] = sudokuBoard.GetCandidates( spot / 9, spot % 9 );
+            }
+        }
+
+        PropagateLockstep( lanes, boardType );
+
+        for( int lane = 0; lane < groupSize; lane++ )
+        {
+            SudokuBoard& sudokuBoard = boards[group[lane]];
+            if( lanes.noSolution[lane] != 0 )
+                continue;
+
+            std::array<uint8_t, 9*9> values;
+            for( int spot = 0; spot < 9*9; spot++ )
+                values[spot] = static_cast<uint8_t>( lanes.values[spot][lane] );
+
+            SudokuBoard propagated( values, boardType );
+            SolveStats* boardStats = stats != nullptr ? &stats[group[lane]] : nullptr;
+            if( boardStats != nullptr )
+                boardStats->searchSinglePlacements += sudokuBoard.GetEmptySpotCount() - propagated.GetEmptySpotCount();
+
+            if( lanes.filled[lane] != 0 )
+            {
+                sudokuBoard = propagated;
+                continue;
+            }
+
+            SolveOnItsOwn( propagated, boardStats );
+            if( propagated.IsBoardSolved() )
+                sudokuBoard = propagated;
+        }
+    }
+#endif
+}
+
+void SolveBatch( SudokuBoard* boards, size_t count, SolveStats* stats /*= nullptr*/ )
+{
+    if( GetBoardKernelSet() != Avx2Kernels )
+    {
+        for( size_t i = 0; i < count; i++ )
+            SolveOnItsOwn( boards[i], stats != nullptr ? &stats[i] : nullptr );
+        return;
+    }
+
+#if defined(SUDOKU_X86_KERNELS)
+    //Every lane of a group has to have the same variant peers.  A group is solved as soon as it
+    //is full and whatever is left of each one at the end.
+    LockstepBoards lanes;
+    std::array<std::array<size_t, LockstepLaneCount>, 4> groups;
+    std::array<int, 4> groupSizes = {};
+    for( size_t i = 0; i < count; i++ )
+    {
+        BoardType boardType = boards[i].GetBoardType();
+        groups[boardType][groupSizes[boardType]++] = i;
+        if( groupSizes[boardType] == LockstepLaneCount )
+        {
+            SolveLockstepGroup( boards, groups[boardType].data(), LockstepLaneCount, boardType, stats, lanes );
+            groupSizes[boardType] = 0;
+        }
+    }
+
+    for( int boardType = Traditional; boardType <= QueenSudoku; boardType++ )
+    {
+        if( groupSizes[boardType] > 0 )
+            SolveLockstepGroup( boards, groups[boardType].data(), groupSizes[boardType], static_cast<BoardType>( boardType ), stats, lanes );
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+
+#include <cstddef>
+#include <vector>
+
+//Boards LockstepSolver propagates at once, one per 16 bit lane of an AVX2 register
+const int LockstepLaneCount = 16;
+
+//Solves count boards, replacing each one that has a solution with it; the others are left as they
+//were, so check IsBoardSolved().  With AVX2 the boards are grouped by board type and naked and
+//hidden singles are placed on a whole group at once, a lane per board, until none of them places
+//anything more.  Boards that then still need a guess are searched one by one with
+//SudokuSolver::Solve, as are all of them on CPUs without AVX2.  stats, when given, is an array of
+//count SolveStats that each board's stats are added to.
+void SolveBatch( SudokuBoard* boards, size_t count, SolveStats* stats = nullptr );
+
+inline void SolveBatch( std::vector<SudokuBoard>& boards )
+{
+   SolveBatch( boards.data(), boards.size() );
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "PackedPuzzle.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char PackedMagic[] = "SUDOKUP";
+    const uint8_t HasSolutionsFlag = 1;
+    const uint8_t IsCanonicalFlag = 2;
+
+    void AppendPackedBoard( std::string& output, const SudokuBoard& sudokuBoard )
+    {
+        uint8_t packed[PackedBoardSize];
+        sudokuBoard.Pack( packed );
+        output.append( reinterpret_cast<const char*>( packed ), PackedBoardSize );
+    }
+}
+
+void AppendPackedHeader( std::string& output, bool hasSolutions, bool isCanonical /*= false*/ )
+{
+    output.append( PackedMagic, PackedHeaderSize - 1 );
+    output += static_cast<char>( ( hasSolutions ? HasSolutionsFlag : 0 ) | ( isCanonical ? IsCanonicalFlag : 0 ) );
+}
+
+void AppendPackedRecord( std::string& output, const SudokuBoard& puzzle, const SudokuBoard* solution, bool hasSolutions )
+{
+    output += static_cast<char>( puzzle.GetBoardType() );
+    AppendPackedBoard( output, puzzle );
+    if( !hasSolutions )
+        return;
+
+    if( solution != nullptr )
+        AppendPackedBoard( output, *solution );
+    else
+        output.append( PackedBoardSize, '\0' );
+}
+
+bool PackedPuzzleView::IsValid() const
+{
+    if( _record[0] > QueenSudoku )
+        return false;
+
+    const uint8_t* boards[] = { GetPlacements(), _hasSolution ? GetSolution() : nullptr };
+    for( const uint8_t* board : boards )
+    {
+        if( board == nullptr )
+            continue;
+
+        for( int i = 0; i < PackedBoardSize; i++ )
+        {
+            if( ( board[i] & 0xF ) > 9 || ( board[i] >> 4 ) > 9 )
+                return false;
+        }
+    }
+    return true;
+}
+
+PackedPuzzleFile::PackedPuzzleFile()
+: _data( nullptr )
+, _size( 0 )
+, _recordCount( 0 )
+, _hasSolutions( false )
+, _isCanonical( false )
+{
+}
+
+PackedPuzzleFile::~PackedPuzzleFile()
+{
+    Close();
+}
+
+bool PackedPuzzleFile::Open( const std::string& fileName )
+{
+    Close();
+
+#if defined(_WIN32)
+    std::ifstream file( fileName, std::ios::binary );
+    if( !file )
+        return false;
+    _contents.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+    _data = _contents.data();
+    _size = _contents.size();
+#else
+    int fd = open( fileName.c_str(), O_RDONLY );
+    if( fd < 0 )
+        return false;
+
+    struct stat fileStat;
+    if( fstat( fd, &fileStat ) != 0 || fileStat.st_size < static_cast<off_t>( PackedHeaderSize ) )
+    {
+        close( fd );
+        return false;
+    }
+
+    //The mapping stays valid after the descriptor is closed
+    void* mapping = mmap( nullptr, static_cast<size_t>( fileStat.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if( mapping == MAP_FAILED )
+        return false;
+
+    madvise( mapping, static_cast<size_t>( fileStat.st_size ), MADV_SEQUENTIAL );
+    _data = static_cast<const uint8_t*>( mapping );
+    _size = static_cast<size_t>( fileStat.st_size );
+#endif
+
+    if( _size < PackedHeaderSize || std::memcmp( _data, PackedMagic, PackedHeaderSize - 1 ) != 0 )
+    {
+        Close();
+        return false;
+    }
+
+    _hasSolutions = ( _data[PackedHeaderSize - 1] & HasSolutionsFlag ) != 0;
+    _isCanonical = ( _data[PackedHeaderSize - 1] & IsCanonicalFlag ) != 0;
+    _recordCount = ( _size - PackedHeaderSize ) / GetPackedRecordSize( _hasSolutions );
+    return true;
+}
+
+void PackedPuzzleFile::Close()
+{
+#if defined(_WIN32)
+    _contents.clear();
+#else
+    if( _data != nullptr )
+        munmap( const_cast<uint8_t*>( _data ), _size );
+#endif
+
+    _data = nullptr;
+    _size = 0;
+    _recordCount = 0;
+    _hasSolutions = false;
+    _isCanonical = false;
+}
\ No newline at end of file
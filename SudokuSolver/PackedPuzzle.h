@@ -0,0 +1,87 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Puzzles packed into fixed size binary records, half the size of the text lines and with nothing
+//to parse.  A file is a header followed by the records:
+//  header: the 7 characters "SUDOKUP" and a flags byte, bit 0 set when the records have solutions
+//          and bit 1 when every puzzle is already what Canonicalize (CanonicalBoard.h) makes of it
+//  record: the BoardType as a byte, then the puzzle packed as SudokuBoard::Pack writes it, then
+//          the solution packed the same way if the file has them (all 0 when there is none)
+const size_t PackedHeaderSize = 8;
+
+inline size_t GetPackedRecordSize( bool hasSolutions )
+{
+   return 1 + PackedBoardSize * ( hasSolutions ? 2 : 1 );
+}
+
+void AppendPackedHeader( std::string& output, bool hasSolutions, bool isCanonical = false );
+//solution is only written when hasSolutions is set; nullptr writes an empty board
+void AppendPackedRecord( std::string& output, const SudokuBoard& puzzle, const SudokuBoard* solution, bool hasSolutions );
+
+//A record inside a PackedPuzzleFile, only good for as long as the file stays open
+class PackedPuzzleView
+{
+public:
+   PackedPuzzleView( const uint8_t* record, bool hasSolution )
+   : _record( record )
+   , _hasSolution( hasSolution )
+   {
+   }
+
+   //Checks the board type byte and that no packed value is above 9
+   bool IsValid() const;
+
+   BoardType GetBoardType() const { return static_cast<BoardType>( _record[0] ); }
+   const uint8_t* GetPlacements() const { return _record + 1; }
+
+   bool HasSolution() const { return _hasSolution; }
+   const uint8_t* GetSolution() const { return _record + 1 + PackedBoardSize; }
+
+   SudokuBoard GetBoard() const { return SudokuBoard( GetPlacements(), GetBoardType() ); }
+
+private:
+   const uint8_t* _record;
+   bool _hasSolution;
+};
+
+//Maps a packed file into memory and hands out views of its records without copying them.  Where
+//there is no mmap (Windows) the whole file is read in instead.
+class PackedPuzzleFile
+{
+public:
+   PackedPuzzleFile();
+   ~PackedPuzzleFile();
+
+   PackedPuzzleFile( const PackedPuzzleFile& ) = delete;
+   PackedPuzzleFile& operator=( const PackedPuzzleFile& ) = delete;
+
+   //Returns false if the file cannot be read or does not start with the header
+   bool Open( const std::string& fileName );
+   void Close();
+
+   //A record cut short at the end of the file is left out
+   size_t GetRecordCount() const { return _recordCount; }
+   bool HasSolutions() const { return _hasSolutions; }
+   bool IsCanonical() const { return _isCanonical; }
+
+   PackedPuzzleView GetRecord( size_t index ) const
+   {
+      return PackedPuzzleView( _data + PackedHeaderSize + index * GetPackedRecordSize( _hasSolutions ), _hasSolutions );
+   }
+
+private:
+   const uint8_t* _data;
+   size_t _size;
+   size_t _recordCount;
+   bool _hasSolutions;
+   bool _isCanonical;
+#if defined(_WIN32)
+   std::vector<uint8_t> _contents;
+#endif
+};
\ No newline at end of file
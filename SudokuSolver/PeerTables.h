@@ -0,0 +1,216 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <array>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//Spots are numbered row*9 + col.  Everything in here is worked out at compile time so walking
+//the peers of a spot is just reading a table.
+
+struct PeerList
+{
+   uint8_t count;
+   uint8_t cells[20];
+};
+
+typedef std::array<PeerList, 9*9> PeerTable;
+
+//A bit for each spot: spots 0-63 in the first word, 64-80 in the second
+struct SpotSet
+{
+   uint64_t words[2];
+};
+
+//The index of the lowest bit set; bits must not be 0
+inline int FindLowestBit( uint64_t bits )
+{
+#if defined(_MSC_VER)
+   unsigned long index;
+   _BitScanForward64( &index, bits );
+   return static_cast<int>( index );
+#else
+   return __builtin_ctzll( bits );
+#endif
+}
+
+inline int CountBits( uint64_t bits )
+{
+#if defined(_MSC_VER)
+   return static_cast<int>( __popcnt64( bits ) );
+#else
+   return __builtin_popcountll( bits );
+#endif
+}
+
+//Units 0-8 are the rows, 9-17 the columns and 18-26 the 3x3 grids
+typedef std::array<std::array<uint8_t, 9>, 3*9> UnitTable;
+
+constexpr int GridIndexOf( int row, int col )
+{
+   return (row / 3) * 3 + col / 3;
+}
+
+namespace PeerTablesDetail
+{
+   constexpr bool IsOnBoard( int row, int col )
+   {
+      return row >= 0 && row < 9 && col >= 0 && col < 9;
+   }
+
+   constexpr void Add( PeerList& list, int row, int col )
+   {
+      list.cells[list.count++] = static_cast<uint8_t>( row*9 + col );
+   }
+
+   constexpr UnitTable MakeUnits()
+   {
+      UnitTable units{};
+      for( int i = 0; i < 9; i++ )
+      {
+         for( int j = 0; j < 9; j++ )
+         {
+            units[i][j] = static_cast<uint8_t>( i*9 + j );
+            units[9 + i][j] = static_cast<uint8_t>( j*9 + i );
+            units[18 + i][j] = static_cast<uint8_t>( ((i / 3) * 3 + j / 3) * 9 + (i % 3) * 3 + j % 3 );
+         }
+      }
+      return units;
+   }
+
+   constexpr PeerTable MakeUnitPeers()
+   {
+      PeerTable table{};
+      for( int row = 0; row < 9; row++ )
+      {
+         for( int col = 0; col < 9; col++ )
+         {
+            PeerList& list = table[row*9 + col];
+            for( int c = 0; c < 9; c++ )
+            {
+               if( c != col )
+                  Add( list, row, c );
+            }
+            for( int r = 0; r < 9; r++ )
+            {
+               if( r != row )
+                  Add( list, r, col );
+            }
+            for( int r = (row / 3) * 3; r < (row / 3) * 3 + 3; r++ )
+            {
+               for( int c = (col / 3) * 3; c < (col / 3) * 3 + 3; c++ )
+               {
+                  if( r != row && c != col )
+                     Add( list, r, c );
+               }
+            }
+         }
+      }
+      return table;
+   }
+
+   //Knight and king peers come from a list of offsets; the queen peers are both diagonals
+   constexpr PeerTable MakeVariantPeers( BoardType boardType )
+   {
+      constexpr int knightOffsets[8][2] = { {-2, -1 }, {-1, -2}, {1, -2}, {2, -1}, {-2, 1}, {-1, 2}, {1, 2}, {2, 1} };
+      constexpr int kingOffsets[8][2] = { {-1, -1 }, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+
+      PeerTable table{};
+      for( int row = 0; row < 9; row++ )
+      {
+         for( int col = 0; col < 9; col++ )
+         {
+            PeerList& list = table[row*9 + col];
+            if( boardType == KnightSudoku || boardType == KingSudoku )
+            {
+               for( int i = 0; i < 8; i++ )
+               {
+                  int r = row + ( boardType == KnightSudoku ? knightOffsets[i][1] : kingOffsets[i][1] );
+                  int c = col + ( boardType == KnightSudoku ? knightOffsets[i][0] : kingOffsets[i][0] );
+                  if( IsOnBoard( r, c ) )
+                     Add( list, r, c );
+               }
+            }
+            else if( boardType == QueenSudoku )
+            {
+               for( int x = 1; x < 9; x++ )
+               {
+                  if( IsOnBoard( row - x, col - x ) )
+                     Add( list, row - x, col - x );
+                  if( IsOnBoard( row - x, col + x ) )
+                     Add( list, row - x, col + x );
+                  if( IsOnBoard( row + x, col - x ) )
+                     Add( list, row + x, col - x );
+                  if( IsOnBoard( row + x, col + x ) )
+                     Add( list, row + x, col + x );
+               }
+            }
+         }
+      }
+      return table;
+   }
+
+   constexpr void AddSpot( SpotSet& set, int spot )
+   {
+      set.words[spot / 64] |= 1ull << ( spot % 64 );
+   }
+
+   constexpr std::array<SpotSet, 3*9> MakeUnitSpotSets( const UnitTable& units )
+   {
+      std::array<SpotSet, 3*9> sets{};
+      for( int unit = 0; unit < 3*9; unit++ )
+      {
+         for( int spot : units[unit] )
+            AddSpot( sets[unit], spot );
+      }
+      return sets;
+   }
+
+   constexpr std::array<SpotSet, 9*9> MakePeerSpotSets( const PeerTable& unitPeers, const PeerTable& variantPeers )
+   {
+      std::array<SpotSet, 9*9> sets{};
+      for( int index = 0; index < 9*9; index++ )
+      {
+         for( int i = 0; i < unitPeers[index].count; i++ )
+            AddSpot( sets[index], unitPeers[index].cells[i] );
+         for( int i = 0; i < variantPeers[index].count; i++ )
+            AddSpot( sets[index], variantPeers[index].cells[i] );
+      }
+      return sets;
+   }
+}
+
+//The row, column and 3x3 grid peers of every spot (20 each)
+inline constexpr PeerTable UnitPeers = PeerTablesDetail::MakeUnitPeers();
+
+inline constexpr UnitTable Units = PeerTablesDetail::MakeUnits();
+
+//The extra peers each BoardType adds, indexed by BoardType.  For a QueenSudoku these only
+//constrain the value 9.
+inline constexpr std::array<PeerTable, 4> VariantPeers = {
+   PeerTablesDetail::MakeVariantPeers( Traditional ),
+   PeerTablesDetail::MakeVariantPeers( KnightSudoku ),
+   PeerTablesDetail::MakeVariantPeers( KingSudoku ),
+   PeerTablesDetail::MakeVariantPeers( QueenSudoku )
+};
+
+//Whether a variant peer of a spot holding value constrains that value
+constexpr bool VariantPeersConstrain( BoardType boardType, int value )
+{
+   return boardType != QueenSudoku || value == 9;
+}
+
+//The same as bits: the spots of each unit, and the unit and variant peers of each spot together
+//indexed by BoardType
+inline constexpr std::array<SpotSet, 3*9> UnitSpotSets = PeerTablesDetail::MakeUnitSpotSets( Units );
+
+inline constexpr std::array<std::array<SpotSet, 9*9>, 4> PeerSpotSets = {
+   PeerTablesDetail::MakePeerSpotSets( UnitPeers, VariantPeers[Traditional] ),
+   PeerTablesDetail::MakePeerSpotSets( UnitPeers, VariantPeers[KnightSudoku] ),
+   PeerTablesDetail::MakePeerSpotSets( UnitPeers, VariantPeers[KingSudoku] ),
+   PeerTablesDetail::MakePeerSpotSets( UnitPeers, VariantPeers[QueenSudoku] )
+};
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "PuzzleGenerator.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+    //Puzzles handed to a worker thread at a time
+    const size_t PuzzlesPerChunk = 64;
+
+    void AppendPuzzle( std::string& output, const SudokuBoard& puzzle )
+    {
+        const char* boardTypeTags[] = { "", "knight:", "king:", "queen:" };
+        output += boardTypeTags[puzzle.GetBoardType()];
+        for( int index = 0; index < 9*9; index++ )
+        {
+            output += static_cast<char>( '0' + puzzle.GetAt( index / 9, index % 9 ) );
+        }
+        output += '\n';
+    }
+
+    uint64_t SeedForPuzzle( uint64_t seed, size_t puzzleIndex )
+    {
+        return seed ^ ( ( puzzleIndex + 1 ) * 0x9E3779B97F4A7C15ull );
+    }
+}
+
+PuzzleGenerator::PuzzleGenerator( uint64_t seed )
+{
+    Seed( seed );
+}
+
+void PuzzleGenerator::Seed( uint64_t seed )
+{
+    _random.seed( seed );
+
+    //Shuffled in place by every puzzle, so it would otherwise carry over the ones before
+    for( int index = 0; index < 9*9; index++ )
+    {
+        _spotOrder[index] = static_cast<uint8_t>( index );
+    }
+}
+
+bool PuzzleGenerator::Generate( const GeneratorOptions& options, SudokuBoard& puzzle )
+{
+    bool checkStrategies = options.maxStrategy < TakingGuessStrategy;
+    bool gradePuzzle = options.minStrategy > MissingValueStrategy;
+
+    for( int attempt = 0; attempt < options.maxAttempts; attempt++ )
+    {
+        SudokuBoard filled( "", options.boardType );
+        while( !FillRandomly( filled ) )
+        {
+            filled = SudokuBoard( "", options.boardType );
+        }
+
+        //A fresh board without the fill's trail since clues get taken away with SetAt
+        std::array<uint8_t, 9*9> values;
+        for( int index = 0; index < 9*9; index++ )
+        {
+            values[index] = static_cast<uint8_t>( filled.GetAt( index / 9, index % 9 ) );
+        }
+        puzzle = SudokuBoard( values, options.boardType );
+
+        std::shuffle( _spotOrder.begin(), _spotOrder.end(), _random );
+        int clues = 9*9;
+        for( int index : _spotOrder )
+        {
+            if( clues <= options.targetClues )
+                break;
+
+            int row = index / 9;
+            int col = index % 9;
+            int value = puzzle.GetAt( row, col );
+            puzzle.SetAt( row, col, 0 );
+
+            //The puzzle had only the one solution, so it still does unless another value fits here
+            SudokuBoard otherValue = puzzle;
+            otherValue.EliminateCandidates( row, col, CandidateBit( value ) );
+            SudokuSolver solver( otherValue );
+            bool isUnique = solver.CountSolutions( 1 ) == 0;
+
+            SolveStrategy hardestStrategy;
+            if( isUnique && checkStrategies && !IsSolvableWithin( puzzle, options.maxStrategy, hardestStrategy ) )
+                isUnique = false;
+
+            if( isUnique )
+                clues--;
+            else
+                puzzle.SetAt( row, col, value );
+        }
+
+        SolveStrategy hardestStrategy = NoStrategy;
+        if( !gradePuzzle || ( IsSolvableWithin( puzzle, options.maxStrategy, hardestStrategy ) && hardestStrategy >= options.minStrategy ) )
+            return true;
+    }
+
+    return false;
+}
+
+//The 9s of a QueenSudoku go down first, one row at a time, since filling spot by spot can take
+//very long to find out that they cannot all fit
+bool PuzzleGenerator::FillRandomly( SudokuBoard& sudokuBoard )
+{
+    if( sudokuBoard.GetBoardType() == QueenSudoku && !PlaceRandomNines( sudokuBoard, 0 ) )
+        return false;
+
+    return FillSpotsRandomly( sudokuBoard );
+}
+
+//Fills the most constrained spot first with its candidates in a random order
+bool PuzzleGenerator::FillSpotsRandomly( SudokuBoard& sudokuBoard )
+{
+    int bestIndex = -1;
+    int bestCount = 10;
+    for( int index = 0; index < 9*9 && bestCount > 1; index++ )
+    {
+        if( sudokuBoard.GetAt( index / 9, index % 9 ) != 0 )
+            continue;
+
+        int count = CountCandidates( sudokuBoard.GetCandidates( index / 9, index % 9 ) );
+        if( count == 0 )
+            return false;
+        if( count < bestCount )
+        {
+            bestCount = count;
+            bestIndex = index;
+        }
+    }
+
+    if( bestIndex < 0 )
+        return true;
+
+    int row = bestIndex / 9;
+    int col = bestIndex % 9;
+    std::array<int, 9> values;
+    int valueCount = 0;
+    uint16_t candidates = sudokuBoard.GetCandidates( row, col );
+    for( int value = 1; value <= 9; value++ )
+    {
+        if( candidates & CandidateBit( value ) )
+            values[valueCount++] = value;
+    }
+    std::shuffle( values.begin(), values.begin() + valueCount, _random );
+
+    for( int i = 0; i < valueCount; i++ )
+    {
+        sudokuBoard.Place( row, col, values[i] );
+        if( FillSpotsRandomly( sudokuBoard ) )
+            return true;
+        sudokuBoard.Undo();
+    }
+    return false;
+}
+
+bool PuzzleGenerator::PlaceRandomNines( SudokuBoard& sudokuBoard, int row )
+{
+    if( row == 9 )
+        return true;
+
+    std::array<int, 9> cols = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::shuffle( cols.begin(), cols.end(), _random );
+    for( int col : cols )
+    {
+        if( !( sudokuBoard.GetCandidates( row, col ) & CandidateBit( 9 ) ) )
+            continue;
+
+        sudokuBoard.Place( row, col, 9 );
+        if( PlaceRandomNines( sudokuBoard, row + 1 ) )
+            return true;
+        sudokuBoard.Undo();
+    }
+    return false;
+}
+
+//Steps through the puzzle the way the hints do with only the strategies up to maxStrategy
+bool PuzzleGenerator::IsSolvableWithin( const SudokuBoard& puzzle, SolveStrategy maxStrategy, SolveStrategy& hardestStrategy )
+{
+    SudokuSolver solver( puzzle );
+    for( int strategy = maxStrategy + 1; strategy < StrategyCount; strategy++ )
+    {
+        solver.SetStrategyEnabled( static_cast<SolveStrategy>( strategy ), false );
+    }
+
+    while( solver.SolveOneStep() );
+    hardestStrategy = solver.GetStats().hardestStrategy;
+    return solver.DidSolvePuzzle();
+}
+
+size_t GeneratePuzzles( const GeneratorOptions& options, size_t count, int threads, std::ostream& output )
+{
+    ThreadPool threadPool( threads );
+    std::vector<PuzzleGenerator> generators( threadPool.GetThreadCount(), PuzzleGenerator( options.seed ) );
+
+    //Chunks are written in order once every chunk of a round is done
+    const size_t chunksPerRound = 4 * generators.size();
+    std::vector<std::string> chunkOutputs( chunksPerRound );
+    size_t written = 0;
+
+    for( size_t roundStart = 0; roundStart < count; roundStart += chunksPerRound * PuzzlesPerChunk )
+    {
+        for( size_t chunk = 0; chunk < chunksPerRound; chunk++ )
+        {
+            size_t first = roundStart + chunk * PuzzlesPerChunk;
+            size_t last = std::min( count, first + PuzzlesPerChunk );
+            chunkOutputs[chunk].clear();
+            if( first >= last )
+                continue;
+
+            threadPool.Submit( [&, chunk, first, last]( int workerIndex )
+            {
+                PuzzleGenerator& generator = generators[workerIndex];
+                SudokuBoard puzzle( "", options.boardType );
+                for( size_t i = first; i < last; i++ )
+                {
+                    generator.Seed( SeedForPuzzle( options.seed, i ) );
+                    if( generator.Generate( options, puzzle ) )
+                        AppendPuzzle( chunkOutputs[chunk], puzzle );
+                }
+            });
+        }
+
+        threadPool.Wait();
+        for( const std::string& chunkOutput : chunkOutputs )
+        {
+            output.write( chunkOutput.data(), chunkOutput.size() );
+            written += std::count( chunkOutput.begin(), chunkOutput.end(), '\n' );
+        }
+    }
+
+    return written;
+}
\ No newline at end of file
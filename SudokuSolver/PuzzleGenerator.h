@@ -0,0 +1,52 @@
+#pragma once
+
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+
+struct GeneratorOptions
+{
+   BoardType boardType = Traditional;
+   int targetClues = 0;//Stops taking clues away once down to this many; 0 takes away all it can
+   //Only takes a clue away if the puzzle can still be solved without strategies harder than
+   //maxStrategy, and throws away puzzles that do not need minStrategy
+   SolveStrategy maxStrategy = TakingGuessStrategy;
+   SolveStrategy minStrategy = MissingValueStrategy;
+   int maxAttempts = 100;//Full grids tried before giving up on minStrategy
+   uint64_t seed = 0;
+};
+
+//Makes puzzles with exactly one solution: a random full grid that keeps the rules of the board
+//type, then clues taken away in a random order as long as CountSolutions( 2 ) still finds only
+//one solution.  Keeps its random numbers and scratch state from one puzzle to the next, so
+//use one per thread.
+class PuzzleGenerator
+{
+public:
+   explicit PuzzleGenerator( uint64_t seed );
+
+   //Starts over so the puzzles that follow only depend on seed
+   void Seed( uint64_t seed );
+
+   //Returns false if no puzzle met options.minStrategy within options.maxAttempts
+   bool Generate( const GeneratorOptions& options, SudokuBoard& puzzle );
+
+private:
+   bool FillRandomly( SudokuBoard& sudokuBoard );
+   bool FillSpotsRandomly( SudokuBoard& sudokuBoard );
+   bool PlaceRandomNines( SudokuBoard& sudokuBoard, int row );
+   bool IsSolvableWithin( const SudokuBoard& puzzle, SolveStrategy maxStrategy, SolveStrategy& hardestStrategy );
+
+   std::mt19937_64 _random;
+   std::array<uint8_t, 9*9> _spotOrder;
+};
+
+//Generates count puzzles on threads threads (0 for every core) and writes them to output in the
+//--batch format, tagged with their board type.  Puzzle i always comes from the same seed so the
+//output only depends on options.seed.  Returns how many were written.
+size_t GeneratePuzzles( const GeneratorOptions& options, size_t count, int threads, std::ostream& output );
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "PuzzleParser.h"
+
+#include <cstring>
+
+namespace
+{
+    bool IsSeparator( char ch )
+    {
+        switch( ch )
+        {
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+            case '|':
+            case '-':
+            case '+':
+            case '=':
+            case ',':
+                return true;
+        }
+        return false;
+    }
+
+    bool IsLetter( char ch )
+    {
+        return ( ch >= 'a' && ch <= 'z' ) || ( ch >= 'A' && ch <= 'Z' );
+    }
+
+    bool Fail( ParseError* error, size_t position, const char* message )
+    {
+        if( error != nullptr )
+        {
+            error->position = position;
+            error->message = message;
+        }
+        return false;
+    }
+}
+
+bool ParseBoardTypeTag( const char* text, size_t length, BoardType& boardType )
+{
+    struct BoardTypeTag
+    {
+        const char* name;
+        BoardType boardType;
+    };
+    const BoardTypeTag tags[] = { { "traditional", Traditional }, { "classic", Traditional }, { "knight", KnightSudoku }, { "king", KingSudoku }, { "queen", QueenSudoku } };
+
+    for( const BoardTypeTag& tag : tags )
+    {
+        if( std::strlen( tag.name ) == length && std::memcmp( tag.name, text, length ) == 0 )
+        {
+            boardType = tag.boardType;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParsePuzzle( const char* text, size_t length, std::array<uint8_t, 9*9>& values, BoardType& boardType, ParseError* error /*= nullptr*/ )
+{
+    boardType = Traditional;
+
+    size_t position = 0;
+    while( position < length && IsSeparator( text[position] ) )
+        position++;
+
+    //A tag is the letters up to a ':'
+    size_t tagEnd = position;
+    while( tagEnd < length && IsLetter( text[tagEnd] ) )
+        tagEnd++;
+    if( tagEnd > position )
+    {
+        if( tagEnd == length || text[tagEnd] != ':' )
+            return Fail( error, position, "expected a value or a board type tag ending in ':'" );
+        if( !ParseBoardTypeTag( text + position, tagEnd - position, boardType ) )
+            return Fail( error, position, "unknown board type tag" );
+        position = tagEnd + 1;
+    }
+
+    int count = 0;
+    for( ; position < length; position++ )
+    {
+        char ch = text[position];
+        if( IsSeparator( ch ) )
+            continue;
+
+        if( ch == '.' )
+            ch = '0';
+        if( ch < '0' || ch > '9' )
+            return Fail( error, position, "expected a value, '0' or '.'" );
+        if( count == 9*9 )
+            return Fail( error, position, "more than 81 values" );
+
+        values[count++] = static_cast<uint8_t>( ch - '0' );
+    }
+
+    if( count < 9*9 )
+        return Fail( error, length, "fewer than 81 values" );
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//Where and why ParsePuzzle gave up
+struct ParseError
+{
+   size_t position = 0;//Offset into the text
+   const char* message = "";
+};
+
+//"traditional" (or "classic"), "knight", "king" or "queen"
+bool ParseBoardTypeTag( const char* text, size_t length, BoardType& boardType );
+
+//Reads a 9x9 puzzle: an optional board type tag followed by a ':', then the 81 values row by row
+//with '0' or '.' for an empty spot.  Whitespace, line breaks and the '|', '-', '+', '=' and ','
+//of grid layouts can go anywhere between the values.  Stops at the first thing that does not fit
+//and, when error is given, says where.  Does not allocate.
+bool ParsePuzzle( const char* text, size_t length, std::array<uint8_t, 9*9>& values, BoardType& boardType, ParseError* error = nullptr );
+
+inline bool ParsePuzzle( const std::string& text, std::array<uint8_t, 9*9>& values, BoardType& boardType, ParseError* error = nullptr )
+{
+   return ParsePuzzle( text.data(), text.size(), values, boardType, error );
+}
\ No newline at end of file
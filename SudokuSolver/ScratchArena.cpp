@@ -0,0 +1,66 @@
+#include "ScratchArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace
+{
+    //Enough for a Dancing Links matrix or a Canonicalize search, so most threads only take one
+    const size_t FirstBlockSize = 1 << 20;
+
+    //Blocks double in size so this many is far more than can ever be needed
+    const size_t MaxBlockCount = 32;
+}
+
+ScratchArena& ScratchArena::ForThisThread()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::ScratchArena()
+: _position{ 0, 0 }
+, _heapAllocations( 0 )
+{
+    _blocks.reserve( MaxBlockCount );
+}
+
+void* ScratchArena::AllocateBytes( size_t size, size_t alignment )
+{
+    assert( alignment <= alignof( std::max_align_t ) );
+
+    for( ;; )
+    {
+        //A block too small for this is skipped; it gets used again once the scope ends
+        if( _position.block < _blocks.size() )
+        {
+            Block& block = _blocks[_position.block];
+            size_t start = ( _position.used + alignment - 1 ) & ~( alignment - 1 );
+            if( start + size <= block.size )
+            {
+                _position.used = start + size;
+                return block.memory.get() + start;
+            }
+
+            _position.block++;
+            _position.used = 0;
+            continue;
+        }
+
+        size_t blockSize = std::max( size, _blocks.empty() ? FirstBlockSize : 2*_blocks.back().size );
+        _blocks.push_back( Block{ std::unique_ptr<unsigned char[]>( new unsigned char[blockSize] ), blockSize } );
+        _heapAllocations++;
+    }
+}
+
+ScratchScope::ScratchScope()
+: _arena( ScratchArena::ForThisThread() )
+, _start( _arena._position )
+{
+}
+
+ScratchScope::~ScratchScope()
+{
+    _arena._position = _start;
+}
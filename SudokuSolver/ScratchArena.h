@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+//Memory for the scratch work of a solve, handed out by moving along blocks taken from the heap
+//and all given back at once when the ScratchScope it was taken in ends.  Blocks are kept once
+//taken, so after the first few puzzles a thread solves it needs no more from the heap.  One per
+//thread.
+class ScratchArena
+{
+public:
+   //The calling thread's arena
+   static ScratchArena& ForThisThread();
+
+   ScratchArena( const ScratchArena& ) = delete;
+   ScratchArena& operator=( const ScratchArena& ) = delete;
+
+   //Room for count Ts, not initialized, until the innermost ScratchScope ends
+   template<typename T>
+   T* Allocate( size_t count )
+   {
+      static_assert( std::is_trivially_destructible<T>::value, "Nothing is destroyed when a scope ends" );
+      return static_cast<T*>( AllocateBytes( count * sizeof( T ), alignof( T ) ) );
+   }
+
+   //Blocks taken from the heap so far
+   uint64_t GetHeapAllocations() const { return _heapAllocations; }
+
+private:
+   friend class ScratchScope;
+
+   struct Block
+   {
+      std::unique_ptr<unsigned char[]> memory;
+      size_t size;
+   };
+
+   //Where the next allocation goes
+   struct Position
+   {
+      size_t block;
+      size_t used;
+   };
+
+   ScratchArena();
+
+   void* AllocateBytes( size_t size, size_t alignment );
+
+   std::vector<Block> _blocks;
+   Position _position;
+   uint64_t _heapAllocations;
+};
+
+//Gives back everything taken from the thread's ScratchArena while it was open
+class ScratchScope
+{
+public:
+   ScratchScope();
+   ~ScratchScope();
+
+   ScratchScope( const ScratchScope& ) = delete;
+   ScratchScope& operator=( const ScratchScope& ) = delete;
+
+   ScratchArena& GetArena() const { return _arena; }
+
+private:
+   ScratchArena& _arena;
+   ScratchArena::Position _start;
+};
@@ -0,0 +1,191 @@
+#include "SolutionCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace
+{
+    SolutionCache::Key MakeKey( const SudokuBoard& sudokuBoard )
+    {
+        SolutionCache::Key key;
+        key[0] = static_cast<uint8_t>( sudokuBoard.GetBoardType() );
+        sudokuBoard.Pack( key.data() + 1 );
+        return key;
+    }
+
+    //All 0 stands for no solution, as in a packed record
+    bool IsNoSolution( const uint8_t* packedSolution )
+    {
+        return std::all_of( packedSolution, packedSolution + PackedBoardSize, []( uint8_t byte ) { return byte == 0; } );
+    }
+
+    bool IsSolution( const SudokuBoard& solution )
+    {
+        return solution.IsBoardSolved() && solution.IsBoardValid();
+    }
+
+    bool DoesSolve( const SudokuBoard& solution, const SudokuBoard& puzzle )
+    {
+        if( !IsSolution( solution ) )
+            return false;
+
+        for( int index = 0; index < 9*9; index++ )
+        {
+            int value = puzzle.GetAt( index / 9, index % 9 );
+            if( value != 0 && value != solution.GetAt( index / 9, index % 9 ) )
+                return false;
+        }
+        return true;
+    }
+}
+
+size_t SolutionCache::KeyHash::operator()( const Key& key ) const
+{
+    //FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for( uint8_t byte : key )
+    {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>( hash );
+}
+
+bool SolutionCache::Find( const SudokuBoard& puzzle, SudokuBoard& solution, Lookup& lookup )
+{
+    PackedSolution packedSolution;
+    lookup.puzzle = MakeKey( puzzle );
+    {
+        std::shared_lock<std::shared_mutex> lock( _mutex );
+        auto found = _puzzleSolutions.find( lookup.puzzle );
+        if( found != _puzzleSolutions.end() )
+        {
+            solution = IsNoSolution( found->second.data() ) ? puzzle : SudokuBoard( found->second.data(), puzzle.GetBoardType() );
+            return true;
+        }
+    }
+
+    lookup.canonical = MakeKey( Canonicalize( puzzle, &lookup.symmetry ) );
+    {
+        std::shared_lock<std::shared_mutex> lock( _mutex );
+        auto found = _canonicalSolutions.find( lookup.canonical );
+        if( found == _canonicalSolutions.end() )
+            return false;
+        packedSolution = found->second;
+    }
+
+    if( IsNoSolution( packedSolution.data() ) )
+    {
+        solution = puzzle;
+    }
+    else
+    {
+        solution = lookup.symmetry.Reverse( SudokuBoard( packedSolution.data(), puzzle.GetBoardType() ) );
+        solution.Pack( packedSolution.data() );
+    }
+
+    //So the next time it is asked for as it is it needs no Canonicalize
+    std::unique_lock<std::shared_mutex> lock( _mutex );
+    _puzzleSolutions[lookup.puzzle] = packedSolution;
+    return true;
+}
+
+void SolutionCache::Add( const Lookup& lookup, const SudokuBoard& solution )
+{
+    PackedSolution packedSolution = {};
+    PackedSolution canonicalSolution = {};
+    if( IsSolution( solution ) )
+    {
+        solution.Pack( packedSolution.data() );
+        lookup.symmetry.Apply( solution ).Pack( canonicalSolution.data() );
+    }
+
+    std::unique_lock<std::shared_mutex> lock( _mutex );
+    _puzzleSolutions[lookup.puzzle] = packedSolution;
+    _canonicalSolutions[lookup.canonical] = canonicalSolution;
+}
+
+size_t SolutionCache::GetSize() const
+{
+    std::shared_lock<std::shared_mutex> lock( _mutex );
+    return _canonicalSolutions.size();
+}
+
+void SolutionCache::AddCanonical( const Key& canonical, const PackedSolution& solution )
+{
+    std::unique_lock<std::shared_mutex> lock( _mutex );
+    _canonicalSolutions[canonical] = solution;
+}
+
+bool SolutionCache::Load( const std::string& fileName )
+{
+    PackedPuzzleFile file;
+    if( !file.Open( fileName ) || !file.HasSolutions() )
+        return false;
+
+    for( size_t i = 0; i < file.GetRecordCount(); i++ )
+    {
+        PackedPuzzleView record = file.GetRecord( i );
+        if( !record.IsValid() )
+            continue;
+
+        PackedSolution packedSolution;
+        std::memcpy( packedSolution.data(), record.GetSolution(), PackedBoardSize );
+
+        //A file Save wrote only needs reading back
+        if( file.IsCanonical() )
+        {
+            Key canonical;
+            canonical[0] = static_cast<uint8_t>( record.GetBoardType() );
+            std::memcpy( canonical.data() + 1, record.GetPlacements(), PackedBoardSize );
+            AddCanonical( canonical, packedSolution );
+            continue;
+        }
+
+        SudokuBoard puzzle = record.GetBoard();
+        BoardSymmetry symmetry;
+        Key canonical = MakeKey( Canonicalize( puzzle, &symmetry ) );
+        if( !IsNoSolution( packedSolution.data() ) )
+        {
+            SudokuBoard solution( packedSolution.data(), puzzle.GetBoardType() );
+            if( !DoesSolve( solution, puzzle ) )
+                continue;
+            symmetry.Apply( solution ).Pack( packedSolution.data() );
+        }
+        AddCanonical( canonical, packedSolution );
+    }
+    return true;
+}
+
+bool SolutionCache::Save( const std::string& fileName ) const
+{
+    std::string contents;
+    AppendPackedHeader( contents, true, true );
+    {
+        std::shared_lock<std::shared_mutex> lock( _mutex );
+        contents.reserve( contents.size() + _canonicalSolutions.size() * GetPackedRecordSize( true ) );
+        for( const auto& entry : _canonicalSolutions )
+        {
+            contents.append( reinterpret_cast<const char*>( entry.first.data() ), entry.first.size() );
+            contents.append( reinterpret_cast<const char*>( entry.second.data() ), entry.second.size() );
+        }
+    }
+
+    //Written next to it first so a failed write leaves the old file as it was
+    std::string tempName = fileName + ".tmp";
+    {
+        std::ofstream file( tempName, std::ios::binary );
+        if( !file.write( contents.data(), contents.size() ) )
+            return false;
+    }
+
+    if( std::rename( tempName.c_str(), fileName.c_str() ) == 0 )
+        return true;
+
+    //Windows does not rename over a file
+    std::remove( fileName.c_str() );
+    return std::rename( tempName.c_str(), fileName.c_str() ) == 0;
+}
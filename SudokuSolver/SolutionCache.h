@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CanonicalBoard.h"
+#include "PackedPuzzle.h"
+#include "SudokuBoard.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+//Solutions of puzzles solved before, found again for the same puzzle or any rearrangement of it
+//Canonicalize knows about.  A puzzle seen as it is costs a hash lookup; a rearranged one costs a
+//Canonicalize, tens of microseconds for a Traditional board.  Load and Save keep the solutions
+//in a packed file (PackedPuzzle.h) of canonical puzzles.  Safe to use from many threads at once.
+class SolutionCache
+{
+public:
+   //A board type byte then a board packed by SudokuBoard::Pack, as in a packed record
+   typedef std::array<uint8_t, 1 + PackedBoardSize> Key;
+
+   //What Find works out about a puzzle, for Add to use when it was not there
+   struct Lookup
+   {
+      Key puzzle;
+      Key canonical;
+      BoardSymmetry symmetry;
+   };
+
+   //Returns whether the cache has the puzzle or a rearrangement of it, setting solution to its
+   //solution.  A puzzle known to have none gets itself back, so check IsBoardSolved().
+   bool Find( const SudokuBoard& puzzle, SudokuBoard& solution, Lookup& lookup );
+   //solution is what solving the puzzle Find was given came to; one that is not solved is kept as
+   //the puzzle having no solution
+   void Add( const Lookup& lookup, const SudokuBoard& solution );
+
+   //Canonical puzzles kept
+   size_t GetSize() const;
+
+   //Adds the records of a packed file with solutions, one Save or --packed-output wrote.  Records
+   //of a file Save did not write are canonicalized and left out when their solution does not
+   //solve their puzzle.  Returns false if the file cannot be read or has no solutions.
+   bool Load( const std::string& fileName );
+   //Writes every canonical puzzle and its solution, all 0 for none, replacing the file
+   bool Save( const std::string& fileName ) const;
+
+private:
+   typedef std::array<uint8_t, PackedBoardSize> PackedSolution;
+
+   struct KeyHash
+   {
+      size_t operator()( const Key& key ) const;
+   };
+
+   void AddCanonical( const Key& canonical, const PackedSolution& solution );
+
+   mutable std::shared_mutex _mutex;
+   std::unordered_map<Key, PackedSolution, KeyHash> _canonicalSolutions;
+   //Only in memory: the puzzles as they were given, so a repeat needs no Canonicalize
+   std::unordered_map<Key, PackedSolution, KeyHash> _puzzleSolutions;
+};
@@ -0,0 +1,78 @@
+#include "SolverEngine.h"
+
+#include "DancingLinksSolver.h"
+#include "LockstepSolver.h"
+#include "ScratchArena.h"
+
+#include <chrono>
+
+namespace
+{
+    SudokuBoard Solve( const SudokuBoard& sudokuBoard, SolverEngine engine, SolveStats* stats, TranspositionTable* transpositions )
+    {
+        switch( engine )
+        {
+            case HumanStyleEngine:
+            {
+                SudokuSolver solver( sudokuBoard );
+                solver.SetTranspositionTable( transpositions );
+                while( solver.SolveOneStep() );
+                if( stats != nullptr )
+                    stats->Add( solver.GetStats() );
+                return solver.GetBoardSolving();
+            }
+            case BacktrackingEngine:
+            {
+                SudokuSolver solver( sudokuBoard );
+                solver.SetTranspositionTable( transpositions );
+                solver.Solve();
+                if( stats != nullptr )
+                    stats->Add( solver.GetStats() );
+                return solver.GetBoardSolving();
+            }
+            case DancingLinksEngine:
+            {
+                auto start = std::chrono::steady_clock::now();
+                DancingLinksSolver solver( sudokuBoard );
+                solver.Solve();
+                if( stats != nullptr )
+                    stats->searchSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+                return solver.GetBoardSolving();
+            }
+            case LockstepEngine:
+            {
+                SudokuBoard solution = sudokuBoard;
+                SolveBatch( &solution, 1, stats );
+                return solution;
+            }
+        }
+
+        return sudokuBoard;
+    }
+}
+
+SudokuBoard SolveWithEngine( const SudokuBoard& sudokuBoard, SolverEngine engine, SolveStats* stats /*= nullptr*/, TranspositionTable* transpositions /*= nullptr*/ )
+{
+    const ScratchArena& arena = ScratchArena::ForThisThread();
+    uint64_t heapAllocations = arena.GetHeapAllocations();
+    SudokuBoard solution = Solve( sudokuBoard, engine, stats, transpositions );
+    if( stats != nullptr )
+        stats->scratchAllocations += arena.GetHeapAllocations() - heapAllocations;
+    return solution;
+}
+
+bool ParseSolverEngine( const std::string& name, SolverEngine& engine )
+{
+    if( name == "human" )
+        engine = HumanStyleEngine;
+    else if( name == "backtracking" )
+        engine = BacktrackingEngine;
+    else if( name == "dlx" )
+        engine = DancingLinksEngine;
+    else if( name == "lockstep" )
+        engine = LockstepEngine;
+    else
+        return false;
+
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+
+enum SolverEngine
+{
+   HumanStyleEngine,//SudokuSolver::SolveOneStep until it gets stuck, the way the hints are found
+   BacktrackingEngine,//SudokuSolver::Solve
+   DancingLinksEngine,//DancingLinksSolver::Solve
+   LockstepEngine//SolveBatch; the batch solver hands it many boards at once
+};
+
+//Solves a copy of sudokuBoard with the given engine; check IsBoardSolved() on the result.
+//When stats is given the solver's SolveStats are added to it (Dancing Links only reports its time
+//as searchSeconds and its scratchAllocations).  The human and backtracking engines search with
+//transpositions when given it.
+SudokuBoard SolveWithEngine( const SudokuBoard& sudokuBoard, SolverEngine engine, SolveStats* stats = nullptr, TranspositionTable* transpositions = nullptr );
+
+//Parses "human", "backtracking", "dlx" or "lockstep"; returns false for anything else
+bool ParseSolverEngine( const std::string& name, SolverEngine& engine );
@@ -1,31 +1,132 @@
 #include "SudokuBoard.h"
 
+#include "BoardKernels.h"
+#include "PeerTables.h"
+
 #include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+static_assert( std::is_trivially_copyable<SudokuBoard>::value, "SudokuBoard should be copyable with a memcpy" );
 
 namespace
 {
-    bool AllUniqueNumbers( std::vector<int> numbers )
+    //Calls func( index ) for every spot that cannot share value with the spot at index.
+    //For a QueenSudoku the diagonals only constrain the 9s, so they are only visited when value is 9
+    //(or 0 meaning any value).
+    template<typename Func>
+    void ForEachPeer( BoardType boardType, int index, int value, Func func )
+    {
+        const PeerList& unitPeers = UnitPeers[index];
+        for( int i = 0; i < unitPeers.count; i++ )
+        {
+            func( unitPeers.cells[i] );
+        }
+
+        if( value != 0 && !VariantPeersConstrain( boardType, value ) )
+            return;
+
+        const PeerList& variantPeers = VariantPeers[boardType][index];
+        for( int i = 0; i < variantPeers.count; i++ )
+        {
+            func( variantPeers.cells[i] );
+        }
+    }
+
+    //Random keys XORed into SudokuBoard's hash for each value at each spot, 0 for an empty spot,
+    //and for the board type
+    struct ZobristKeys
+    {
+        uint64_t spots[9*9][10] = {};
+        uint64_t boardTypes[4] = {};
+    };
+
+    constexpr uint64_t SplitMix64( uint64_t& state )
     {
-        std::sort(std::begin(numbers), std::end(numbers));
-        auto pos = std::adjacent_find(std::begin(numbers), std::end(numbers));
-        if (pos != std::end(numbers))
-            return false;
-        // we have a duplicate
-        return true;
+        uint64_t z = ( state += 0x9E3779B97F4A7C15ull );
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+        return z ^ ( z >> 31 );
+    }
+
+    constexpr ZobristKeys MakeZobristKeys()
+    {
+        ZobristKeys keys;
+        uint64_t state = 0x5D0C0B0A4D5EEDull;
+        for( int index = 0; index < 9*9; index++ )
+        {
+            for( int value = 1; value <= 9; value++ )
+                keys.spots[index][value] = SplitMix64( state );
+        }
+        for( uint64_t& key : keys.boardTypes )
+            key = SplitMix64( state );
+        return keys;
+    }
+
+    constexpr ZobristKeys Zobrist = MakeZobristKeys();
+
+    std::vector<int> GetNumbersAt( const std::array<uint8_t, 9*9>& placements, const PeerList& peers )
+    {
+        std::vector<int> result;
+        for( int i = 0; i < peers.count; i++ )
+        {
+            int value = placements[peers.cells[i]];
+            if( value == 0)
+                continue;
+            result.push_back( value );
+        }
+        return result;
     }
 }
 
 SudokuBoard::SudokuBoard( const std::string& placements, BoardType boardType /*= Traditional*/ )
-: _boardType( boardType )
+: _trailSize( 0 )
+, _boardType( boardType )
 {
-    _placements.resize( 9*9, 0/*initial value*/ );
+    _placements.fill( 0 );
 
-    auto it = _placements.begin();
-    for( char ch : placements )
+    size_t count = std::min( placements.size(), _placements.size() );
+    for( size_t index = 0; index < count; index++ )
     {
-        int value = ch - '0';
-        *it = value;
-        it++;
+        char ch = placements[index];
+        if( ch >= '1' && ch <= '9' )
+            _placements[index] = static_cast<uint8_t>( ch - '0' );
+    }
+
+    RecalculateMasks();
+}
+
+SudokuBoard::SudokuBoard( const std::array<uint8_t, 9*9>& values, BoardType boardType )
+: _trailSize( 0 )
+, _boardType( boardType )
+{
+    for( int index = 0; index < 9*9; index++ )
+    {
+        _placements[index] = values[index] <= 9 ? values[index] : 0;
+    }
+
+    RecalculateMasks();
+}
+
+SudokuBoard::SudokuBoard( const uint8_t* packedPlacements, BoardType boardType )
+: _trailSize( 0 )
+, _boardType( boardType )
+{
+    for( int index = 0; index < 9*9; index++ )
+    {
+        int value = ( packedPlacements[index / 2] >> ( 4 * ( index % 2 ) ) ) & 0xF;
+        _placements[index] = static_cast<uint8_t>( value <= 9 ? value : 0 );
+    }
+
+    RecalculateMasks();
+}
+
+void SudokuBoard::Pack( uint8_t* packedPlacements ) const
+{
+    for( int i = 0; i < PackedBoardSize; i++ )
+    {
+        int high = 2*i + 1 < 9*9 ? _placements[2*i + 1] : 0;
+        packedPlacements[i] = static_cast<uint8_t>( _placements[2*i] | ( high << 4 ) );
     }
 }
 
@@ -38,115 +139,260 @@ int SudokuBoard::GetAt( int row, int col ) const
 void SudokuBoard::SetAt( int row, int col, int value )
 {
    int index = row*9 + col;
-   _placements[index] = value;
+   int previousValue = _placements[index];
+   if( previousValue == value )
+      return;
+
+   int previousValuePeers = 0;
+   if( previousValue != 0 )
+   {
+      previousValuePeers = CountPeersWithValue( index, previousValue );
+      _conflicts -= previousValuePeers;
+   }
+   if( value != 0 )
+      _conflicts += CountPeersWithValue( index, value );
+
+   if( previousValue == 0 )
+      _emptySpots--;
+   else if( value == 0 )
+      _emptySpots++;
+
+   _placements[index] = static_cast<uint8_t>( value );
+   _hash ^= Zobrist.spots[index][previousValue] ^ Zobrist.spots[index][value];
+
+   //Only when the value taken away is still on a peer do the masks need working out from scratch
+   if( previousValuePeers != 0 )
+   {
+      RecalculateUnitMasks( index );
+   }
+   else
+   {
+      int row = index / 9;
+      int col = index % 9;
+      int gridIndex = GridIndexOf( row, col );
+      uint16_t keep = previousValue != 0 ? ~CandidateBit( previousValue ) : AllCandidates;
+      uint16_t add = value != 0 ? CandidateBit( value ) : 0;
+      _rowMasks[row] = ( _rowMasks[row] & keep ) | add;
+      _colMasks[col] = ( _colMasks[col] & keep ) | add;
+      _gridMasks[gridIndex] = ( _gridMasks[gridIndex] & keep ) | add;
+   }
+
+   if( previousValue != 0 )
+   {
+      //Taking a value away can give it back to the peers
+      RestoreCandidateToPeers( index, previousValue );
+   }
+
+   if( value != 0 )
+   {
+      _candidates[index] = 0;
+      RemoveCandidateFromPeers( index, value );
+   }
+   else
+   {
+      RecalculateCandidates( index );
+   }
 }
 
-bool SudokuBoard::IsBoardValid() const
+bool SudokuBoard::SetAtChecked( int row, int col, int value )
 {
-    //Any duplicates on same row
-    for( int row=0; row < 9; row++)
+   if( value != 0 && !IsPlacementLegal( row, col, value ) )
+      return false;
+
+   SetAt( row, col, value );
+   return true;
+}
+
+bool SudokuBoard::IsPlacementLegal( int row, int col, int value ) const
+{
+   return CountPeersWithValue( row*9 + col, value ) == 0;
+}
+
+bool SudokuBoard::EliminateCandidates( int row, int col, uint16_t candidates )
+{
+   int index = row*9 + col;
+   if( !( _candidates[index] & candidates ) )
+      return false;
+
+   _candidates[index] &= ~candidates;
+   return true;
+}
+
+int SudokuBoard::FindSpotWithFewestCandidates() const
+{
+    return ::FindSpotWithFewestCandidates( _candidates.data(), _placements.data() );
+}
+
+void SudokuBoard::CountCandidatesOfAllSpots( std::array<uint8_t, 9*9>& counts ) const
+{
+    ::CountCandidatesOfAllSpots( _candidates.data(), counts.data() );
+}
+
+void SudokuBoard::Place( int row, int col, int value )
+{
+    assert( GetAt( row, col ) == 0 && value != 0 );
+
+    SetAt( row, col, value );
+    _trail[_trailSize++] = static_cast<uint8_t>( row*9 + col );
+}
+
+void SudokuBoard::Undo()
+{
+    assert( _trailSize > 0 );
+
+    //Emptying the spot again works the candidates of its peers out again
+    int index = _trail[--_trailSize];
+    SetAt( index / 9, index % 9, 0 );
+}
+
+void SudokuBoard::UndoTo( int trailSize )
+{
+    while( _trailSize > trailSize )
     {
-        std::vector<int> values = GetNumbersOnRow( row );
-        if( !AllUniqueNumbers( values ) )
-        {
-            return false;
-        }
+        Undo();
     }
-    
-    //Any duplicates on same column
-    for( int col=0; col < 9; col++)
+}
+
+void SudokuBoard::RecalculateMasks()
+{
+    //These 9 spots cover every row, every column and every 3x3 grid once
+    for( int i = 0; i < 9; i++ )
     {
-        std::vector<int> values = GetNumbersOnCol( col );
-        if( !AllUniqueNumbers( values ) )
-        {
-            return false;
-        }
+        RecalculateUnitMasks( i*9 + (i % 3) * 3 + i / 3 );
     }
 
-    //Any duplicates in same 3x3 grid
-    for( int gridIndex=0; gridIndex < 9; gridIndex++)
+    //Every conflicting pair gets found from both ends.  Most boards have none, which one pass of
+    //HasNoConflictingPeers shows for much less than counting them spot by spot.
+    bool hasConflicts = !HasNoConflictingPeers( _placements.data(), _boardType );
+    int conflicts = 0;
+    _emptySpots = 0;
+    _hash = Zobrist.boardTypes[_boardType];
+    for( int index = 0; index < 9*9; index++ )
     {
-        std::vector<int> values = GetNumbersIn3x3Grid( gridIndex );
-        if( !AllUniqueNumbers( values ) )
-        {
-            return false;
-        }
+        RecalculateCandidates( index );
+        _hash ^= Zobrist.spots[index][_placements[index]];
+
+        if( _placements[index] == 0 )
+            _emptySpots++;
+
+        if( hasConflicts && _placements[index] != 0 )
+            conflicts += CountPeersWithValue( index, _placements[index] );
     }
+    _conflicts = static_cast<int16_t>( conflicts / 2 );
+}
+
+void SudokuBoard::RecalculateUnitMasks( int index )
+{
+    int row = index / 9;
+    int col = index % 9;
+    int gridIndex = GridIndexOf( row, col );
 
-    if( _boardType == KnightSudoku )
+    uint16_t rowMask = 0, colMask = 0, gridMask = 0;
+    for( int i = 0; i < 9; i++ )
     {
-        for( int row=0; row < 9; row++)
-        {
-            for( int col=0; col<9; col++)
-            {
-                int value = GetAt( row, col );
-                if( value == 0 )
-                    continue;
-
-                std::vector<int> values = GetNumbersKnightsDistance( row, col );
-                if( std::find( values.begin(), values.end(), value ) != values.end() )
-                {
-                    return false;
-                }
-            }
-        }
+        int value = _placements[Units[row][i]];
+        if( value != 0 )
+            rowMask |= CandidateBit( value );
+
+        value = _placements[Units[9 + col][i]];
+        if( value != 0 )
+            colMask |= CandidateBit( value );
+
+        value = _placements[Units[18 + gridIndex][i]];
+        if( value != 0 )
+            gridMask |= CandidateBit( value );
     }
-    if( _boardType == KingSudoku )
+
+    _rowMasks[row] = rowMask;
+    _colMasks[col] = colMask;
+    _gridMasks[gridIndex] = gridMask;
+}
+
+void SudokuBoard::RecalculateCandidates( int index )
+{
+    if( _placements[index] != 0 )
     {
-        for( int row=0; row < 9; row++)
-        {
-            for( int col=0; col<9; col++)
-            {
-                int value = GetAt( row, col );
-                if( value == 0 )
-                    continue;
-
-                std::vector<int> values = GetNumbersKingsDistance( row, col );
-                if( std::find( values.begin(), values.end(), value ) != values.end() )
-                {
-                    return false;
-                }
-            }
-        }
+        _candidates[index] = 0;
+        return;
     }
-    else if( _boardType == QueenSudoku )
+
+    int row = index / 9;
+    int col = index % 9;
+    uint16_t used = _rowMasks[row] | _colMasks[col] | _gridMasks[GridIndexOf( row, col )] | GetVariantMask( index );
+    _candidates[index] = AllCandidates & ~used;
+}
+
+void SudokuBoard::RemoveCandidateFromPeers( int index, int value )
+{
+    uint16_t keep = ~CandidateBit( value );
+    ForEachPeer( _boardType, index, value, [this, keep]( int peer ) { _candidates[peer] &= keep; } );
+}
+
+void SudokuBoard::RestoreCandidateToPeers( int index, int value )
+{
+    uint16_t bit = CandidateBit( value );
+    ForEachPeer( _boardType, index, value, [this, value, bit]( int peer )
     {
-        for( int row=0; row < 9; row++)
+        if( _placements[peer] != 0 || ( _candidates[peer] & bit ) )
+            return;
+
+        int row = peer / 9;
+        int col = peer % 9;
+        if( ( _rowMasks[row] | _colMasks[col] | _gridMasks[GridIndexOf( row, col )] ) & bit )
+            return;
+
+        if( VariantPeersConstrain( _boardType, value ) )
         {
-            for( int col=0; col<9; col++)
+            const PeerList& variantPeers = VariantPeers[_boardType][peer];
+            for( int i = 0; i < variantPeers.count; i++ )
             {
-                int value = GetAt( row, col );
-                if( value == 0 )
-                    continue;
-
-                if( value == 9 )
-                {
-                    std::vector<int> values = GetNumbersQueensDistance( row, col );
-                    if( std::find( values.begin(), values.end(), value ) != values.end() )
-                    {
-                        return false;
-                    }
-                }
+                if( _placements[variantPeers.cells[i]] == value )
+                    return;
             }
         }
-    }
 
-    return true;
+        _candidates[peer] |= bit;
+    });
 }
 
-bool SudokuBoard::IsBoardSolved() const
+int SudokuBoard::CountPeersWithValue( int index, int value ) const
 {
-    for( int row=0; row < 9; row++)
+    int count = 0;
+    ForEachPeer( _boardType, index, value, [this, value, &count]( int peer )
     {
-        for( int col = 0; col < 9; col++)
-        {
-            int value = GetAt( row, col );
-            if( value == 0 )
-               return false;
-        }
+        if( _placements[peer] == value )
+            count++;
+    });
+    return count;
+}
+
+uint16_t SudokuBoard::GetVariantMask( int index ) const
+{
+    uint16_t mask = 0;
+    const PeerList& peers = VariantPeers[_boardType][index];
+    for( int i = 0; i < peers.count; i++ )
+    {
+        int value = _placements[peers.cells[i]];
+        if( value != 0 && VariantPeersConstrain( _boardType, value ) )
+            mask |= CandidateBit( value );
     }
+    return mask;
+}
+
+bool SudokuBoard::IsBoardValid() const
+{
+    assert( (_conflicts == 0) == IsBoardValidFullScan() );
+    return _conflicts == 0;
+}
 
-    return true;
+bool SudokuBoard::IsBoardValidFullScan() const
+{
+    return HasNoConflictingPeers( _placements.data(), _boardType );
+}
+
+bool SudokuBoard::IsBoardSolved() const
+{
+    return _emptySpots == 0;
 }
 
 std::vector<int> SudokuBoard::GetNumbersOnRow( int row ) const
@@ -195,143 +441,29 @@ std::vector<int> SudokuBoard::GetNumbersIn3x3Grid( int gridIndex ) const
 
 std::vector<int> SudokuBoard::GetNumbersKnightsDistance( int row, int col ) const
 {
-    std::vector<int> result;
-    std::vector<std::pair<int, int> > offsets{ {-2, -1 }, {-1, -2}, {1, -2}, {2, -1}, {-2, 1}, {-1, 2}, {1, 2}, {2, 1} };
-    for( const auto& offset : offsets )
-    {
-        int x = col + offset.first;
-        int y = row + offset.second;
-
-        if( x < 0 || x > 8 || y < 0 || y > 8 )
-            continue;
-
-        int value = GetAt( y, x );
-        if( value == 0)
-            continue;
-        result.push_back( value );
-    }
-
-    return result;
+    return GetNumbersAt( _placements, VariantPeers[KnightSudoku][row*9 + col] );
 }
 
 std::vector<int> SudokuBoard::GetNumbersKingsDistance( int row, int col ) const
 {
-    std::vector<int> result;
-    std::vector<std::pair<int, int> > offsets{ {-1, -1 }, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
-    for( const auto& offset : offsets )
-    {
-        int x = col + offset.first;
-        int y = row + offset.second;
-
-        if( x < 0 || x > 8 || y < 0 || y > 8 )
-            continue;
-
-        int value = GetAt( y, x );
-        if( value == 0)
-            continue;
-        result.push_back( value );
-    }
-
-    return result;
+    return GetNumbersAt( _placements, VariantPeers[KingSudoku][row*9 + col] );
 }
 
 std::vector<int> SudokuBoard::GetNumbersQueensDistance( int row, int col ) const
 {
-    std::vector<int> result;
-
-    for( int r = 0; r < 9; r++ )
-    {
-        int value = GetAt( r, col);
-        if( value == 0)
-            continue;
-        if( row == r )
-            continue;
-
-        result.push_back( value );
-    }
-
-    for( int c = 0; c < 9; c++ )
-    {
-        int value = GetAt( row, c);
-        if( value == 0)
-            continue;
-        if( col == c )
-            continue;
-        result.push_back( value );
-    }
-
-    for( int x = 0; x < 9; x++ )
-    {
-        std::vector<std::pair<int, int> > positions{ {row-x, col-x }, {row-x, col+x}, {row+x, col-x}, {row+x, col+x} };
-
-        for( const auto& position : positions )
-        {
-            int r = position.first;
-            int c = position.second;
-
-            if( c < 0 || c > 8 || r < 0 || r > 8 )
-                continue;
-
-            if( r == row && c == col )
-                continue;
-
-            int value = GetAt( r, c );
-            if( value == 0)
-                continue;
-            result.push_back( value );
-        }
-    }
+    //The first 16 unit peers are the rest of the row and the column
+    PeerList rowAndCol = UnitPeers[row*9 + col];
+    rowAndCol.count = 16;
 
+    std::vector<int> result = GetNumbersAt( _placements, rowAndCol );
+    std::vector<int> numbersOnDiagonals = GetNumbersAt( _placements, VariantPeers[QueenSudoku][row*9 + col] );
+    result.insert( result.end(), numbersOnDiagonals.begin(), numbersOnDiagonals.end() );
     return result;
 }
 
 int SudokuBoard::GetGridIndex( int row, int col ) const
 {
-    if( row >= 0 && row < 3)
-    {
-        if( col >=0 && col < 3 )
-        {
-            return 0;
-        }
-        else if( col >=3 && col < 6 )
-        {
-            return 1;
-        }
-        else
-        {
-            return 2;
-        }
-    }
-    else if( row >= 3 && row < 6)
-    {
-        if( col >=0 && col < 3 )
-        {
-            return 3;
-        }
-        else if( col >=3 && col < 6 )
-        {
-            return 4;
-        }
-        else
-        {
-            return 5;
-        }
-    }
-    else
-    {
-        if( col >=0 && col < 3 )
-        {
-            return 6;
-        }
-        else if( col >=3 && col < 6 )
-        {
-            return 7;
-        }
-        else
-        {
-            return 8;
-        }
-    }
+    return GridIndexOf( row, col );
 }
 
 std::ostream& operator<<(std::ostream& os, const SudokuBoard& sudokoBoard)
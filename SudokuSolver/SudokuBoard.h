@@ -1,10 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
 
-enum BoardType
+enum BoardType : uint8_t
 {
    Traditional,
    KnightSudoku,
@@ -12,18 +14,78 @@ enum BoardType
    QueenSudoku
 };
 
+//Candidates are kept as a bitmask: bit 0 is the value 1 up to bit 8 for the value 9
+const uint16_t AllCandidates = 0x1FF;
+
+inline uint16_t CandidateBit( int value )
+{
+   return static_cast<uint16_t>( 1 << (value - 1) );
+}
+
+inline int CountCandidates( uint16_t candidates )
+{
+   int count = 0;
+   for( ; candidates != 0; candidates &= candidates - 1 )
+      count++;
+   return count;
+}
+
+//Bytes taken by the 81 values of a board packed two to a byte
+const int PackedBoardSize = ( 9*9 + 1 ) / 2;
+
 class SudokuBoard
 {
 public:
+   //Reads at most 81 characters; anything but '1' to '9' is an empty spot.  ParsePuzzle in
+   //PuzzleParser.h is for text that has to be checked.
    SudokuBoard( const std::string& placements, BoardType boardType = Traditional );
+   //Values of 0 to 9 row by row as ParsePuzzle gives them; anything above 9 is an empty spot
+   SudokuBoard( const std::array<uint8_t, 9*9>& values, BoardType boardType );
+   //The 81 values packed two to a byte, spot 2i in the low 4 bits of byte i and 0 for empty, the
+   //way PackedPuzzle.h stores them.  Values above 9 leave the spot empty.
+   SudokuBoard( const uint8_t* packedPlacements, BoardType boardType );
 
    int GetAt( int row, int col ) const;
+   //Writes the values the way the packed constructor reads them, PackedBoardSize bytes
+   void Pack( uint8_t* packedPlacements ) const;
    void SetAt( int row, int col, int value );
 
+   //Only places value if no peer already has it; returns whether it was placed
+   bool SetAtChecked( int row, int col, int value );
+   bool IsPlacementLegal( int row, int col, int value ) const;
+
+   //For trying a value out without copying the board: Place puts a value on an empty spot and
+   //remembers it, Undo takes back the most recent Place.  UndoTo( size ) takes back everything
+   //placed after GetTrailSize() returned size.
+   void Place( int row, int col, int value );
+   void Undo();
+   void UndoTo( int trailSize );
+   int GetTrailSize() const { return _trailSize; }
+
+   //Values that could still be placed at an empty spot; 0 for spots already filled
+   uint16_t GetCandidates( int row, int col ) const { return _candidates[row*9 + col]; }
+   //The empty spot with the fewest candidates, the first one with 0 or 1 if there is one, or -1 if
+   //the board is full
+   int FindSpotWithFewestCandidates() const;
+   //How many candidates each spot has, 0 for filled spots
+   void CountCandidatesOfAllSpots( std::array<uint8_t, 9*9>& counts ) const;
+   //Rules candidates out of an empty spot without placing anything; returns whether any were
+   //there.  SetAt and Undo work candidates out from the placed values again so they can give
+   //some back.
+   bool EliminateCandidates( int row, int col, uint16_t candidates );
+
    BoardType GetBoardType() const { return _boardType; }
 
+   //Zobrist hash of the board type and the placed values, kept up to date by SetAt; the same
+   //placements give the same hash whatever order they were placed in
+   uint64_t GetHash() const { return _hash; }
+
+   //Uses a running count of conflicting peers kept up to date by SetAt
    bool IsBoardValid() const;
+   //Checks every unit and peer; only meant for debugging/asserts
+   bool IsBoardValidFullScan() const;
    bool IsBoardSolved() const;
+   int GetEmptySpotCount() const { return _emptySpots; }
 
    std::vector<int> GetNumbersOnRow( int row ) const;
    std::vector<int> GetNumbersOnCol( int col ) const;
@@ -37,6 +99,33 @@ public:
    friend std::ostream& operator<<(std::ostream& os, const SudokuBoard& sudokoBoard);
 
 private:
-   std::vector<int> _placements;
+   void RecalculateMasks();
+   void RecalculateUnitMasks( int index );
+   void RecalculateCandidates( int index );
+   void RemoveCandidateFromPeers( int index, int value );
+   void RestoreCandidateToPeers( int index, int value );
+   int CountPeersWithValue( int index, int value ) const;
+   uint16_t GetVariantMask( int index ) const;
+
+   //Everything is stored inline so a board can be copied with a memcpy; the widest members come
+   //first to keep them packed
+   uint64_t _hash;
+   std::array<uint16_t, 9*9> _candidates;
+
+   //Values already placed in each row/col/3x3 grid
+   std::array<uint16_t, 9> _rowMasks;
+   std::array<uint16_t, 9> _colMasks;
+   std::array<uint16_t, 9> _gridMasks;
+
+   //Number of pairs of peers holding the same value
+   int16_t _conflicts;
+
+   std::array<uint8_t, 9*9> _placements;
+   uint8_t _emptySpots;
+
+   //Spots filled by Place, most recent last
+   std::array<uint8_t, 9*9> _trail;
+   uint8_t _trailSize;
+
    BoardType _boardType;
 };
\ No newline at end of file
@@ -1,181 +1,524 @@
 #include "SudokuSolver.h"
 
+#include "PeerTables.h"
+#include "TranspositionTable.h"
+
 #include <algorithm>
 #include <cassert>
-#include <tuple>
+#include <chrono>
+#include <cstdint>
+#include <thread>
 #include <utility>
 #include <vector>
 
 namespace
 {
-    void RemoveTheseNumbers( std::vector<int>& values, const std::vector<int>& numbersToRemoveIfExists )
+    //Adds the wall time from construction to destruction to seconds
+    class PhaseTimer
     {
-        for( int n : numbersToRemoveIfExists )
+    public:
+        explicit PhaseTimer( double& seconds )
+        : _seconds( seconds )
+        , _start( std::chrono::steady_clock::now() )
         {
-            auto it = std::find( values.begin(), values.end(), n );
-            if( it != values.end() )
-            {
-                values.erase( it );
-            }
         }
-    }
 
-    void RemoveNumbersFromPossibilities( const SudokuBoard& sudokuBoard, std::vector<int>& possibleValues, int row, int col )
-    {
-        RemoveTheseNumbers( possibleValues, sudokuBoard.GetNumbersOnRow( row ) );
-        RemoveTheseNumbers( possibleValues, sudokuBoard.GetNumbersOnCol( col ) );
-        RemoveTheseNumbers( possibleValues, sudokuBoard.GetNumbersIn3x3Grid( sudokuBoard.GetGridIndex( row, col) ) );
-
-        if( sudokuBoard.GetBoardType() == KnightSudoku )
+        ~PhaseTimer()
         {
-            RemoveTheseNumbers( possibleValues, sudokuBoard.GetNumbersKnightsDistance( row, col ) );
+            _seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - _start ).count();
         }
-        else if( sudokuBoard.GetBoardType() == KingSudoku )
+
+    private:
+        double& _seconds;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    //The values in a candidate mask, smallest first, without going to the heap
+    struct CandidateValues
+    {
+        int values[9];
+        int count = 0;
+
+        const int* begin() const { return values; }
+        const int* end() const { return values + count; }
+        int front() const { return values[0]; }
+    };
+
+    CandidateValues GetCandidateValues( uint16_t candidates )
+    {
+        CandidateValues result;
+        for( int value = 1; value <= 9; value++ )
         {
-            RemoveTheseNumbers( possibleValues, sudokuBoard.GetNumbersKingsDistance( row, col ) );
+            if( candidates & CandidateBit( value ) )
+                result.values[result.count++] = value;
         }
-        else if( sudokuBoard.GetBoardType() == QueenSudoku )
+        return result;
+    }
+
+    //Which values are placed in a unit and which are candidates of exactly one or more than one of
+    //its empty spots
+    struct UnitCandidateCounts
+    {
+        uint16_t placed = 0;
+        uint16_t seenOnce = 0;
+        uint16_t seenMoreThanOnce = 0;
+
+        uint16_t HiddenSingles() const { return seenOnce & ~seenMoreThanOnce & ~placed; }
+        bool IsMissingAValue() const { return ( placed | seenOnce ) != AllCandidates; }
+    };
+
+    UnitCandidateCounts CountUnitCandidates( const SudokuBoard& sudokuBoard, int unitIndex )
+    {
+        UnitCandidateCounts counts;
+        for( uint8_t spot : Units[unitIndex] )
         {
-            auto queenDistanceNumbers = sudokuBoard.GetNumbersQueensDistance( row, col );
-            if( std::find( queenDistanceNumbers.begin(), queenDistanceNumbers.end(), 9 ) != queenDistanceNumbers.end() )
+            int value = sudokuBoard.GetAt( spot / 9, spot % 9 );
+            if( value != 0 )
             {
-                RemoveTheseNumbers( possibleValues, std::vector<int>{ 9 } );
+                counts.placed |= CandidateBit( value );
+                continue;
             }
+
+            uint16_t candidates = sudokuBoard.GetCandidates( spot / 9, spot % 9 );
+            counts.seenMoreThanOnce |= counts.seenOnce & candidates;
+            counts.seenOnce |= candidates;
         }
+        return counts;
     }
 
-    bool CouldSpotHaveValue( const SudokuBoard& sudokuBoard, int row, int col, int possibility )
+    //The first spot, in row order, holding a candidate that no other spot in its unit can take,
+    //looking only at units firstUnit to lastUnit (numbered like Units).  Returns -1 if there is none
+    //and otherwise sets value to the smallest such candidate
+    int FindHiddenSingle( const SudokuBoard& sudokuBoard, int firstUnit, int lastUnit, int& value )
     {
-        assert( sudokuBoard.GetAt( row, col ) == 0 );
+        uint16_t hiddenSingles[9*9] = {};
+        for( int unitIndex = firstUnit; unitIndex <= lastUnit; unitIndex++ )
+        {
+            uint16_t unitSingles = CountUnitCandidates( sudokuBoard, unitIndex ).HiddenSingles();
+            if( unitSingles == 0 )
+                continue;
 
-        SudokuBoard copyOfBoard = sudokuBoard;
-        copyOfBoard.SetAt( row, col, possibility );
-        return copyOfBoard.IsBoardValid();
+            for( uint8_t spot : Units[unitIndex] )
+            {
+                if( sudokuBoard.GetAt( spot / 9, spot % 9 ) == 0 )
+                    hiddenSingles[spot] |= sudokuBoard.GetCandidates( spot / 9, spot % 9 ) & unitSingles;
+            }
+        }
+
+        for( int index = 0; index < 9*9; index++ )
+        {
+            if( hiddenSingles[index] != 0 )
+            {
+                value = GetCandidateValues( hiddenSingles[index] ).front();
+                return index;
+            }
+        }
+        return -1;
     }
 
-    bool CouldAnother3x3HaveValue( const SudokuBoard& sudokuBoard, int row, int col, int possibility )
+    bool DoesEveryRowColHasAtLeastOnePossibility( const SudokuBoard& sudokuBoard, SolveStats& stats )
     {
-        int gridIndex = sudokuBoard.GetGridIndex( row, col );
-        int row3x3 = (gridIndex / 3 ) * 3;
-        int col3x3 = (gridIndex * 3) % 9;
-        for( int xOffset = 0; xOffset<3; xOffset++)
+        stats.validityChecks++;
+        for( int row = 0; row < 9; row++ )
         {
-            for( int yOffset = 0; yOffset<3; yOffset++)
+            for( int col = 0; col < 9; col++ )
             {
-                int thisRow = row3x3 + yOffset;
-                int thisCol = col3x3 + xOffset;
-                if( thisRow == row && thisCol == col )
-                    continue;
-
-                int value = sudokuBoard.GetAt( thisRow, thisCol );
-                if( value != 0)
+                int value = sudokuBoard.GetAt( row, col );
+                if( value != 0 )
                     continue;
 
-                if( CouldSpotHaveValue( sudokuBoard, thisRow, thisCol, possibility ) )
-                    return true;
+                if( sudokuBoard.GetCandidates( row, col ) == 0 )
+                    return false;
             }
         }
 
-        return false;
+        return true;
     }
 
-    bool CouldAnotherRowHaveValue( const SudokuBoard& sudokuBoard, int row, int col, int possibility )
+    //After a value is placed on a board whose empty spots all had candidates, only the spot's
+    //peers can have lost their last one
+    bool DoPeersHaveAtLeastOnePossibility( const SudokuBoard& sudokuBoard, int index, SolveStats& stats )
     {
-        for( int y = 0; y<9; y++)
+        stats.validityChecks++;
+        const PeerList* peerLists[] = { &UnitPeers[index], &VariantPeers[sudokuBoard.GetBoardType()][index] };
+        for( const PeerList* peers : peerLists )
         {
-            if( y == row )
-                continue;
+            for( int i = 0; i < peers->count; i++ )
+            {
+                int peer = peers->cells[i];
+                if( sudokuBoard.GetAt( peer / 9, peer % 9 ) == 0 && sudokuBoard.GetCandidates( peer / 9, peer % 9 ) == 0 )
+                    return false;
+            }
+        }
 
-            int value = sudokuBoard.GetAt( y, col );
-            if( value != 0)
+        return true;
+    }
+
+    //Calls found( chosen, covered ) for every choice of size of the masks whose union has exactly
+    //size bits, until found returns true.  chosen has a bit for each mask picked and covered is
+    //their union.  Masks that are 0 are never picked.
+    template<typename Found>
+    bool FindSubset( const uint16_t ( &masks )[9], int size, Found& found, int first = 0, int picked = 0, uint16_t chosen = 0, uint16_t covered = 0 )
+    {
+        if( picked == size )
+            return CountCandidates( covered ) == size && found( chosen, covered );
+
+        for( int i = first; i < 9; i++ )
+        {
+            uint16_t newCovered = covered | masks[i];
+            if( masks[i] == 0 || CountCandidates( newCovered ) > size )
                 continue;
 
-            if( CouldSpotHaveValue( sudokuBoard, y, col, possibility ) )
+            if( FindSubset( masks, size, found, i + 1, picked + 1, static_cast<uint16_t>( chosen | ( 1 << i ) ), newCovered ) )
                 return true;
         }
-
         return false;
     }
 
-    bool CouldAnotherColHaveValue( const SudokuBoard& sudokuBoard, int row, int col, int possibility )
+    //Takes candidates out of the spots of a unit except for those where keep( i ) is true, i being
+    //the spot's position in Units[unitIndex].  Returns how many candidates were taken out.
+    template<typename Keep>
+    int EliminateFromUnit( SudokuBoard& sudokuBoard, int unitIndex, uint16_t candidates, Keep keep )
     {
-        for( int x = 0; x<9; x++)
+        int eliminated = 0;
+        for( int i = 0; i < 9; i++ )
         {
-            if( x == col )
+            int spot = Units[unitIndex][i];
+            if( keep( i ) )
                 continue;
 
-            int value = sudokuBoard.GetAt( row, x );
-            if( value != 0)
+            uint16_t removed = sudokuBoard.GetCandidates( spot / 9, spot % 9 ) & candidates;
+            if( removed == 0 )
                 continue;
 
-            if( CouldSpotHaveValue( sudokuBoard, row, x, possibility ) )
-                return true;
+            sudokuBoard.EliminateCandidates( spot / 9, spot % 9, removed );
+            eliminated += CountCandidates( removed );
         }
+        return eliminated;
+    }
 
-        return false;
+    //A bit for each position in the unit where value is still a candidate
+    uint16_t GetPositionsOfValue( const SudokuBoard& sudokuBoard, int unitIndex, int value )
+    {
+        uint16_t positions = 0;
+        for( int i = 0; i < 9; i++ )
+        {
+            int spot = Units[unitIndex][i];
+            if( sudokuBoard.GetCandidates( spot / 9, spot % 9 ) & CandidateBit( value ) )
+                positions |= 1 << i;
+        }
+        return positions;
     }
 
-    bool DoesEveryRowColHasAtLeastOnePossibility( const SudokuBoard& sudokuBoard )
+    SolveStrategy HarderStrategy( SolveStrategy a, SolveStrategy b )
     {
-        for( int row = 0; row < 9; row++ )
+        if( a == NoStrategy )
+            return b;
+        if( b == NoStrategy )
+            return a;
+        return std::max( a, b );
+    }
+
+    //The row, column and 3x3 grid of a spot as bits of the units numbered like Units
+    uint32_t UnitBitsOf( int index )
+    {
+        int row = index / 9;
+        int col = index % 9;
+        return ( 1u << row ) | ( 1u << ( 9 + col ) ) | ( 1u << ( 18 + GridIndexOf( row, col ) ) );
+    }
+
+    //Spots and units that still have to be checked for singles
+    class PropagationQueue
+    {
+    public:
+        PropagationQueue()
+        : _spots{ ~0ull, ( 1ull << ( 9*9 - 64 ) ) - 1 }
+        , _units( ( 1u << 27 ) - 1 )
         {
-            for( int col = 0; col < 9; col++ )
+        }
+
+        //-1 when there are none left
+        int PopSpot()
+        {
+            for( int word = 0; word < 2; word++ )
             {
-                int value = sudokuBoard.GetAt( row, col );
-                if( value != 0 )
+                if( _spots[word] == 0 )
+                    continue;
+
+                int bit = FindLowestBit( _spots[word] );
+                _spots[word] &= _spots[word] - 1;
+                return word*64 + bit;
+            }
+            return -1;
+        }
+
+        int PopUnit()
+        {
+            if( _units == 0 )
+                return -1;
+
+            int unit = FindLowestBit( _units );
+            _units &= _units - 1;
+            return unit;
+        }
+
+        //Called just before value is placed at index: the empty peers that still have value as a
+        //candidate are about to lose it, so they and their units need checking again
+        void PushPeersLosing( const SudokuBoard& sudokuBoard, int index, int value )
+        {
+            _units |= UnitBitsOf( index );
+
+            BoardType boardType = sudokuBoard.GetBoardType();
+            uint16_t bit = CandidateBit( value );
+            const PeerList* peerLists[] = { &UnitPeers[index], &VariantPeers[boardType][index] };
+            for( const PeerList* peers : peerLists )
+            {
+                if( peers == peerLists[1] && !VariantPeersConstrain( boardType, value ) )
+                    break;
+
+                for( int i = 0; i < peers->count; i++ )
+                {
+                    int peer = peers->cells[i];
+                    if( !( sudokuBoard.GetCandidates( peer / 9, peer % 9 ) & bit ) )
+                        continue;
+
+                    _spots[peer / 64] |= 1ull << ( peer % 64 );
+                    _units |= UnitBitsOf( peer );
+                }
+            }
+        }
+
+    private:
+        uint64_t _spots[2];
+        uint32_t _units;
+    };
+
+    //Places every spot with only one candidate and every value with only one spot left in a
+    //row/col/3x3 grid until there are none left.  After the first pass only the spots and units
+    //around a placed value are looked at again.  Returns false if it finds a spot or a value that
+    //cannot be placed anywhere.
+    bool PropagateSingles( SudokuBoard& sudokuBoard, SolveStats& stats )
+    {
+        PropagationQueue queue;
+
+        for( ;; )
+        {
+            int index = queue.PopSpot();
+            if( index >= 0 )
+            {
+                int row = index / 9;
+                int col = index % 9;
+                if( sudokuBoard.GetAt( row, col ) != 0 )
                     continue;
 
-                std::vector<int> possibleValues{ 1, 2, 3, 4, 5, 6, 7, 8, 9};
-                RemoveNumbersFromPossibilities( sudokuBoard, possibleValues, row, col );
+                uint16_t candidates = sudokuBoard.GetCandidates( row, col );
+                if( candidates == 0 )
+                    return false;
+
+                if( CountCandidates( candidates ) == 1 )
+                {
+                    int value = GetCandidateValues( candidates ).front();
+                    queue.PushPeersLosing( sudokuBoard, index, value );
+                    sudokuBoard.Place( row, col, value );
+                    stats.searchSinglePlacements++;
+                }
+                continue;
+            }
+
+            //Only look for hidden singles once there are no more naked ones
+            int unitIndex = queue.PopUnit();
+            if( unitIndex < 0 )
+                return true;
 
-                if( possibleValues.empty() )
+            UnitCandidateCounts counts = CountUnitCandidates( sudokuBoard, unitIndex );
+            if( counts.IsMissingAValue() )
+                return false;
+
+            uint16_t hiddenSingles = counts.HiddenSingles();
+            if( hiddenSingles == 0 )
+                continue;
+
+            for( uint8_t spot : Units[unitIndex] )
+            {
+                int row = spot / 9;
+                int col = spot % 9;
+                uint16_t candidates = sudokuBoard.GetCandidates( row, col ) & hiddenSingles;
+                if( sudokuBoard.GetAt( row, col ) != 0 || candidates == 0 )
+                    continue;
+
+                //Two values that can only go in the same spot
+                if( CountCandidates( candidates ) > 1 )
                     return false;
+
+                int value = GetCandidateValues( candidates ).front();
+                queue.PushPeersLosing( sudokuBoard, spot, value );
+                sudokuBoard.Place( row, col, value );
+                stats.searchSinglePlacements++;
             }
         }
+    }
 
-        return true;
+    //A value with only two or three spots left in a unit has to go in one of them, so any spot
+    //that is a peer of all of them cannot have it.  Covers pointing pairs and box-line reduction
+    //and, through the variant peers, the spots a knight/king/queen move away.  Returns how many
+    //candidates were taken out.
+    int EliminateSeenByAllSpots( SudokuBoard& sudokuBoard )
+    {
+        BoardType boardType = sudokuBoard.GetBoardType();
+        int eliminated = 0;
+        for( int value = 1; value <= 9; value++ )
+        {
+            SpotSet spotsWithValue = {};
+            for( int index = 0; index < 9*9; index++ )
+            {
+                if( sudokuBoard.GetCandidates( index / 9, index % 9 ) & CandidateBit( value ) )
+                    spotsWithValue.words[index / 64] |= 1ull << ( index % 64 );
+            }
+
+            const auto& peerSpotSets = PeerSpotSets[VariantPeersConstrain( boardType, value ) ? boardType : Traditional];
+            for( int unitIndex = 0; unitIndex < 27; unitIndex++ )
+            {
+                uint64_t positions[2] = { spotsWithValue.words[0] & UnitSpotSets[unitIndex].words[0],
+                                          spotsWithValue.words[1] & UnitSpotSets[unitIndex].words[1] };
+                int count = CountBits( positions[0] ) + CountBits( positions[1] );
+                if( count < 2 || count > 3 )
+                    continue;
+
+                uint64_t seenByAll[2] = { spotsWithValue.words[0], spotsWithValue.words[1] };
+                for( int word = 0; word < 2; word++ )
+                {
+                    for( uint64_t bits = positions[word]; bits != 0; bits &= bits - 1 )
+                    {
+                        const SpotSet& peers = peerSpotSets[word*64 + FindLowestBit( bits )];
+                        seenByAll[0] &= peers.words[0];
+                        seenByAll[1] &= peers.words[1];
+                    }
+                }
+
+                for( int word = 0; word < 2; word++ )
+                {
+                    for( uint64_t bits = seenByAll[word]; bits != 0; bits &= bits - 1 )
+                    {
+                        int spot = word*64 + FindLowestBit( bits );
+                        sudokuBoard.EliminateCandidates( spot / 9, spot % 9, CandidateBit( value ) );
+                        eliminated++;
+                    }
+                    spotsWithValue.words[word] &= ~seenByAll[word];
+                }
+            }
+        }
+        return eliminated;
+    }
+}
+
+namespace
+{
+    struct StrategyStep
+    {
+        SolveStrategy strategy;
+        const char* name;
+        bool ( SudokuSolver::*solveOne )();
+        bool placesValue;
+    };
+
+    const StrategyStep StrategySteps[] =
+    {
+        { MissingValueStrategy, "missingValue", &SudokuSolver::SolveOneMissingValue, true },
+        { Only3x3SpotStrategy, "only3x3Spot", &SudokuSolver::SolveOne3x3OnlySpotForValue, true },
+        { RowColSpotStrategy, "rowColSpot", &SudokuSolver::SolveOneRowColSpotForValue, true },
+        { PointingPairStrategy, "pointingPair", &SudokuSolver::EliminatePointingPairs, false },
+        { BoxLineReductionStrategy, "boxLineReduction", &SudokuSolver::EliminateBoxLineReduction, false },
+        { NakedPairStrategy, "nakedPair", &SudokuSolver::EliminateNakedPairs, false },
+        { HiddenPairStrategy, "hiddenPair", &SudokuSolver::EliminateHiddenPairs, false },
+        { NakedTripleStrategy, "nakedTriple", &SudokuSolver::EliminateNakedTriples, false },
+        { HiddenTripleStrategy, "hiddenTriple", &SudokuSolver::EliminateHiddenTriples, false },
+        { XWingStrategy, "xWing", &SudokuSolver::EliminateXWing, false },
+        { SwordfishStrategy, "swordfish", &SudokuSolver::EliminateSwordfish, false },
+        { TryingPossibilitiesStrategy, "tryingPossibilities", &SudokuSolver::SolveOneTryingPossibilities, true },
+        { TakingGuessStrategy, "takingGuess", &SudokuSolver::SolveOneTakingGuess, true }
+    };
+    static_assert( sizeof( StrategySteps ) / sizeof( StrategySteps[0] ) == StrategyCount, "Every SolveStrategy needs a step, in enum order" );
+}
+
+const char* GetStrategyName( SolveStrategy strategy )
+{
+    return strategy < StrategyCount ? StrategySteps[strategy].name : "none";
+}
+
+bool ParseSolveStrategy( const std::string& name, SolveStrategy& strategy )
+{
+    for( const StrategyStep& step : StrategySteps )
+    {
+        if( name == step.name )
+        {
+            strategy = step.strategy;
+            return true;
+        }
     }
+    return false;
 }
 
 SudokuSolver::SudokuSolver( const SudokuBoard& sudokuBoard )
 : _sudokuBoard( sudokuBoard )
+, _parallelGuesses( false )
+, _enabledStrategies( ( 1 << StrategyCount ) - 1 )
+, _stopSearch( nullptr )
+, _solutionsFound( nullptr )
+, _transpositions( nullptr )
+, _guessDepth( 0 )
 {
 
 }
 
 bool SudokuSolver::SolveOneStep()
 {
-   if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid() )
+   if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ) )
       return false;
 
     //Taking a guess can make it so cannot have any possibility for a spot
-   if( !DoesEveryRowColHasAtLeastOnePossibility( _sudokuBoard ) )
+   if( !DoesEveryRowColHasAtLeastOnePossibility( _sudokuBoard, _stats ) )
    {
        return false;
    }
 
-   if( SolveOneMissingValue() != false )
-      return true;
-
-    if( SolveOne3x3OnlySpotForValue() != false )
-        return true;
+    //Ruling candidates out can let a cheaper strategy place a value so start over after one does
+    int stepIndex = 0;
+    while( stepIndex < StrategyCount )
+    {
+        const StrategyStep& step = StrategySteps[stepIndex];
+        if( !IsStrategyEnabled( step.strategy ) || !( this->*step.solveOne )() )
+        {
+            stepIndex++;
+            continue;
+        }
 
-    if( SolveOneRowColSpotForValue() != false )
-        return true;
+        _stats.hardestStrategy = HarderStrategy( _stats.hardestStrategy, step.strategy );
+        if( step.placesValue )
+            return true;
+        stepIndex = 0;
+    }
 
-    if( SolveOneTryingPossibilities() != false)
-        return true;
+    return false;
+}
 
-   //This means the puzzle is even harder.  Let's copy the board; make a guess and see if it becomes invalid ever
-   if( SolveOneTakingGuess() != false )
-     return true;
+void SudokuSolver::SetStrategyEnabled( SolveStrategy strategy, bool enabled )
+{
+    if( enabled )
+        _enabledStrategies |= 1 << strategy;
+    else
+        _enabledStrategies &= ~( 1 << strategy );
+}
 
-    return false;
+bool SudokuSolver::IsStrategyEnabled( SolveStrategy strategy ) const
+{
+    return ( _enabledStrategies & ( 1 << strategy ) ) != 0;
 }
 
 bool SudokuSolver::SolveOneMissingValue()
 {
-    if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid())
+    PhaseTimer phaseTimer( _stats.missingValueSeconds );
+
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
       return false;
 
    for( int row = 0; row < 9; row++ )
@@ -186,16 +529,15 @@ bool SudokuSolver::SolveOneMissingValue()
           if( value != 0 )
              continue;
 
-            std::vector<int> possibleValues{ 1, 2, 3, 4, 5, 6, 7, 8, 9};
-            RemoveNumbersFromPossibilities( _sudokuBoard, possibleValues, row, col );
+            uint16_t candidates = _sudokuBoard.GetCandidates( row, col );
 
-            if( possibleValues.size() == 1 )
+            if( CountCandidates( candidates ) == 1 )
             {
-                _sudokuBoard.SetAt( row, col, possibleValues.front() );
-                if( _sudokuBoard.IsBoardValid() == false )
+                if( !_sudokuBoard.SetAtChecked( row, col, GetCandidateValues( candidates ).front() ) )
                 {
                     assert(false);
                 }
+                _stats.missingValuePlacements++;
                 return true;
             }
        }
@@ -206,149 +548,105 @@ bool SudokuSolver::SolveOneMissingValue()
 
 bool SudokuSolver::SolveOne3x3OnlySpotForValue()
 {
-    if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid())
-      return false;
-
-   for( int row = 0; row < 9; row++ )
-   {
-       for( int col = 0; col < 9; col++ )
-       {
-          int value = _sudokuBoard.GetAt( row, col );
-          if( value != 0 )
-             continue;
+    PhaseTimer phaseTimer( _stats.only3x3SpotSeconds );
 
-            std::vector<int> possibleValues{ 1, 2, 3, 4, 5, 6, 7, 8, 9};
-            RemoveNumbersFromPossibilities( _sudokuBoard, possibleValues, row, col );
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
 
-            for( int possibility : possibleValues )
-            {
-                //Could this value work on a different spot in the same 3x3 grid?  If not it is this one
-                if( CouldAnother3x3HaveValue( _sudokuBoard, row, col, possibility ) )
-                    continue;
-                
-                _sudokuBoard.SetAt( row, col, possibility );
-                if( _sudokuBoard.IsBoardValid() == false )
-                {
-                    assert(false);
-                }
-                return true;
-            }
-       }
-   }
+    //A value that can only go in one spot of a 3x3 grid
+    int value = 0;
+    int index = FindHiddenSingle( _sudokuBoard, 18, 26, value );
+    if( index < 0 )
+        return false;
 
-   return false;
+    if( !_sudokuBoard.SetAtChecked( index / 9, index % 9, value ) )
+    {
+        assert(false);
+    }
+    _stats.only3x3SpotPlacements++;
+    return true;
 }
 
 bool SudokuSolver::SolveOneRowColSpotForValue()
 {
-    if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid())
-      return false;
+    PhaseTimer phaseTimer( _stats.rowColSpotSeconds );
 
-   for( int row = 0; row < 9; row++ )
-   {
-       for( int col = 0; col < 9; col++ )
-       {
-          int value = _sudokuBoard.GetAt( row, col );
-          if( value != 0 )
-             continue;
-
-            std::vector<int> possibleValues{ 1, 2, 3, 4, 5, 6, 7, 8, 9};
-            RemoveNumbersFromPossibilities( _sudokuBoard, possibleValues, row, col );
-
-            for( int possibility : possibleValues )
-            {
-                //Could this value work on a different spot in the same row?  If not it is this one
-                bool mustBeThisValue = !CouldAnotherRowHaveValue( _sudokuBoard, row, col, possibility );
-
-                if( !mustBeThisValue )
-                {
-                   mustBeThisValue = !CouldAnotherColHaveValue( _sudokuBoard, row, col, possibility );
-                }
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
 
-                if( !mustBeThisValue )
-                    continue;
-                
-                _sudokuBoard.SetAt( row, col, possibility );
-                if( _sudokuBoard.IsBoardValid() == false )
-                {
-                    assert(false);
-                }
-                return true;
-            }
-       }
-   }
+    //A value that can only go in one spot of a row or of a column
+    int value = 0;
+    int index = FindHiddenSingle( _sudokuBoard, 0, 17, value );
+    if( index < 0 )
+        return false;
 
-   return false;
+    if( !_sudokuBoard.SetAtChecked( index / 9, index % 9, value ) )
+    {
+        assert(false);
+    }
+    _stats.rowColSpotPlacements++;
+    return true;
 }
 
 bool SudokuSolver::SolveOneTryingPossibilities()
 {
-    if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid())
-      return false;
+    PhaseTimer phaseTimer( _stats.tryingPossibilitiesSeconds );
 
-    std::vector< std::tuple< std::pair<int, int>, std::vector<int> > > possibilities;
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
 
-    for( int row = 0; row < 9; row++ )
+    std::array<uint8_t, 9*9> counts;
+    _sudokuBoard.CountCandidatesOfAllSpots( counts );
+    for( int index = 0; index < 9*9; index++ )
     {
-       for( int col = 0; col < 9; col++ )
-       {
-          int value = _sudokuBoard.GetAt( row, col );
-          if( value != 0 )
-             continue;
-
-            std::vector<int> possibleValues{ 1, 2, 3, 4, 5, 6, 7, 8, 9};
-            RemoveNumbersFromPossibilities( _sudokuBoard, possibleValues, row, col );
-
-            if( possibleValues.empty() )
-                return false;
-
-            std::tuple< std::pair<int, int>, std::vector<int> > possibility( std::pair<int, int>( row, col ), possibleValues );
-            possibilities.push_back( possibility );
-       }
+        if( counts[index] == 0 && _sudokuBoard.GetAt( index / 9, index % 9 ) == 0 )
+            return false;
     }
 
-    std::sort( possibilities.begin(), possibilities.end(), []( const auto& a, const auto& b )
+    //Spots with the fewest candidates first; filled spots have none so are never tried
+    for( int count = 1; count <= 9; count++ )
     {
-        return std::get<1>(a).size() < std::get<1>(b).size();
-    });
+      for( int index = 0; index < 9*9; index++ )
+      {
+        if( counts[index] != count )
+            continue;
 
-    for( const auto& possibility : possibilities )
-    {
-        std::vector<int> realPossibilities;
+        int realPossibilityCount = 0;
+        int realPossibility = 0;
 
-        std::pair<int, int> location = std::get<0>( possibility );
-        std::vector<int> possibleValues = std::get<1>( possibility );
-        int row = location.first;
-        int col = location.second;
+        int row = index / 9;
+        int col = index % 9;
+        CandidateValues possibleValues = GetCandidateValues( _sudokuBoard.GetCandidates( row, col ) );
 
         for( int possibleValue : possibleValues )
         {
-            SudokuBoard copyOfBoard = _sudokuBoard;
+            //Try it out on the board itself and take it back afterwards
+            _sudokuBoard.Place( row, col, possibleValue );
 
-            copyOfBoard.SetAt(row, col, possibleValue);
+            //Does every spot still have at least a possibility
+            bool isRealPossibility = DoPeersHaveAtLeastOnePossibility( _sudokuBoard, index, _stats ) && IsBoardValid( _sudokuBoard );
 
-            //Does every row/col has at least a possibility
-            if( !DoesEveryRowColHasAtLeastOnePossibility( copyOfBoard ) )
+            _sudokuBoard.Undo();
+
+            if( !isRealPossibility )
             {
                continue;
             }
-            if( copyOfBoard.IsBoardValid() == false )
-            {
-                continue;
-            }
 
-            realPossibilities.push_back( possibleValue );
+            realPossibilityCount++;
+            realPossibility = possibleValue;
         }
 
-        if( realPossibilities.size() == 1 )
+        if( realPossibilityCount == 1 )
         {
-            _sudokuBoard.SetAt( row, col, realPossibilities.front() );
-            if( _sudokuBoard.IsBoardValid() == false )
+            if( !_sudokuBoard.SetAtChecked( row, col, realPossibility ) )
             {
                 assert(false);
             }
+            _stats.tryingPossibilitiesPlacements++;
             return true;
         }
+      }
     }
 
     return false;
@@ -356,115 +654,567 @@ bool SudokuSolver::SolveOneTryingPossibilities()
 
 bool SudokuSolver::SolveOneTakingGuess()
 {
-    if( _sudokuBoard.IsBoardSolved() || !_sudokuBoard.IsBoardValid())
+    PhaseTimer phaseTimer( _stats.takingGuessSeconds );
+
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
       return false;
 
-    std::vector< std::tuple< std::pair<int, int>, std::vector<int> > > possibilities;
+    int index = _sudokuBoard.FindSpotWithFewestCandidates();
+    int row = index / 9;
+    int col = index % 9;
 
-    for( int row = 0; row < 9; row++ )
+    SudokuBoard copyOfBoard = _sudokuBoard;
+    _stats.boardCopies++;
+    bool isSolved = _parallelGuesses ? SearchInParallel( copyOfBoard ) : Search( copyOfBoard );
+    if( !isSolved )
+        return false;
+
+    //Though solved we just want to advance one step
+    if( !_sudokuBoard.SetAtChecked( row, col, copyOfBoard.GetAt( row, col ) ) )
     {
-       for( int col = 0; col < 9; col++ )
-       {
-          int value = _sudokuBoard.GetAt( row, col );
-          if( value != 0 )
-             continue;
+        assert(false);
+    }
+    _stats.takingGuessPlacements++;
+    return true;
+}
+
+bool SudokuSolver::EliminatePointingPairs()
+{
+    PhaseTimer phaseTimer( _stats.eliminatingSeconds );
 
-            std::vector<int> possibleValues{ 1, 2, 3, 4, 5, 6, 7, 8, 9};
-            RemoveNumbersFromPossibilities( _sudokuBoard, possibleValues, row, col );
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
 
-            if( possibleValues.empty() )
+    for( int gridIndex = 0; gridIndex < 9; gridIndex++ )
+    {
+        const auto& grid = Units[18 + gridIndex];
+        for( int value = 1; value <= 9; value++ )
+        {
+            uint16_t rows = 0, cols = 0;
+            for( uint8_t spot : grid )
             {
-                return false;
+                if( _sudokuBoard.GetCandidates( spot / 9, spot % 9 ) & CandidateBit( value ) )
+                {
+                    rows |= 1 << ( spot / 9 );
+                    cols |= 1 << ( spot % 9 );
+                }
             }
 
-            std::tuple< std::pair<int, int>, std::vector<int> > possibility( std::pair<int, int>( row, col ), possibleValues );
-            possibilities.push_back( possibility );
-       }
+            //The value has to go on this row/col inside the grid so no other spot on it can have it
+            uint32_t gridBit = 1u << ( 18 + gridIndex );
+            int eliminated = 0;
+            if( CountCandidates( rows ) == 1 )
+            {
+                int row = FindLowestBit( rows );
+                eliminated += EliminateFromUnit( _sudokuBoard, row, CandidateBit( value ), [&]( int i ) { return ( UnitBitsOf( Units[row][i] ) & gridBit ) != 0; } );
+            }
+            if( CountCandidates( cols ) == 1 )
+            {
+                int col = FindLowestBit( cols );
+                eliminated += EliminateFromUnit( _sudokuBoard, 9 + col, CandidateBit( value ), [&]( int i ) { return ( UnitBitsOf( Units[9 + col][i] ) & gridBit ) != 0; } );
+            }
+
+            if( eliminated != 0 )
+            {
+                _stats.candidatesEliminated += eliminated;
+                return true;
+            }
+        }
     }
 
-    std::sort( possibilities.begin(), possibilities.end(), []( const auto& a, const auto& b )
-    {
-        return std::get<1>(a).size() < std::get<1>(b).size();
-    });
+    return false;
+}
 
-    const auto& firstPossiblity = possibilities.front();
-    std::pair<int, int> location = std::get<0>( firstPossiblity );
-    std::vector<int> possibleValues = std::get<1>( firstPossiblity );
-    int row = location.first;
-    int col = location.second;
+bool SudokuSolver::EliminateBoxLineReduction()
+{
+    PhaseTimer phaseTimer( _stats.eliminatingSeconds );
 
-    std::vector<SudokuSolver> possibleSolvers;
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
 
-    for( int possibleValue : possibleValues )
+    //Rows then cols
+    for( int unitIndex = 0; unitIndex < 18; unitIndex++ )
     {
-        SudokuBoard copyOfBoard = _sudokuBoard;
+        for( int value = 1; value <= 9; value++ )
+        {
+            uint16_t grids = 0;
+            for( uint8_t spot : Units[unitIndex] )
+            {
+                if( _sudokuBoard.GetCandidates( spot / 9, spot % 9 ) & CandidateBit( value ) )
+                    grids |= 1 << GridIndexOf( spot / 9, spot % 9 );
+            }
 
-        copyOfBoard.SetAt(row, col, possibleValue);
+            if( CountCandidates( grids ) != 1 )
+                continue;
 
-        //Does every row/col has at least a possibility
-        if( !DoesEveryRowColHasAtLeastOnePossibility( copyOfBoard ) )
-        {
-            assert(false);
-            continue;
+            //The value has to go in this grid on this row/col so no other spot in the grid can have it
+            int gridIndex = FindLowestBit( grids );
+            uint32_t lineBit = 1u << unitIndex;
+            int eliminated = EliminateFromUnit( _sudokuBoard, 18 + gridIndex, CandidateBit( value ), [&]( int i ) { return ( UnitBitsOf( Units[18 + gridIndex][i] ) & lineBit ) != 0; } );
+            if( eliminated != 0 )
+            {
+                _stats.candidatesEliminated += eliminated;
+                return true;
+            }
         }
+    }
 
-        SudokuSolver solver( copyOfBoard );
+    return false;
+}
 
-        possibleSolvers.push_back( solver );
-    }
+bool SudokuSolver::EliminateNakedPairs()
+{
+    return EliminateNakedSubset( 2 );
+}
 
-    for( int i=0; i<possibleSolvers.size(); )
-    {
-        SudokuSolver solver = possibleSolvers[i];
+bool SudokuSolver::EliminateHiddenPairs()
+{
+    return EliminateHiddenSubset( 2 );
+}
+
+bool SudokuSolver::EliminateNakedTriples()
+{
+    return EliminateNakedSubset( 3 );
+}
+
+bool SudokuSolver::EliminateHiddenTriples()
+{
+    return EliminateHiddenSubset( 3 );
+}
+
+bool SudokuSolver::EliminateXWing()
+{
+    return EliminateFish( 2 );
+}
+
+bool SudokuSolver::EliminateSwordfish()
+{
+    return EliminateFish( 3 );
+}
 
-        while( solver.SolveOneMissingValue() || solver.SolveOne3x3OnlySpotForValue() || solver.SolveOneRowColSpotForValue() || solver.SolveOneTryingPossibilities() );
+bool SudokuSolver::EliminateNakedSubset( int size )
+{
+    PhaseTimer phaseTimer( _stats.eliminatingSeconds );
 
-        const SudokuBoard& copyOfBoard = solver.GetBoardSolving();
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
 
-        if( !DoesEveryRowColHasAtLeastOnePossibility( copyOfBoard ) )
+    for( int unitIndex = 0; unitIndex < 27; unitIndex++ )
+    {
+        //size spots whose candidates are only size values between them
+        uint16_t candidates[9];
+        for( int i = 0; i < 9; i++ )
         {
-            possibleSolvers.erase( possibleSolvers.begin() + i );
-            continue;
+            int spot = Units[unitIndex][i];
+            candidates[i] = _sudokuBoard.GetCandidates( spot / 9, spot % 9 );
         }
 
-        if( copyOfBoard.IsBoardValid() == false )
+        auto found = [&]( uint16_t spots, uint16_t values )
         {
-            possibleSolvers.erase( possibleSolvers.begin() + i );
-            continue;
+            int eliminated = EliminateFromUnit( _sudokuBoard, unitIndex, values, [spots]( int i ) { return ( spots & ( 1 << i ) ) != 0; } );
+            _stats.candidatesEliminated += eliminated;
+            return eliminated != 0;
+        };
+        if( FindSubset( candidates, size, found ) )
+            return true;
+    }
+
+    return false;
+}
+
+bool SudokuSolver::EliminateHiddenSubset( int size )
+{
+    PhaseTimer phaseTimer( _stats.eliminatingSeconds );
+
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
+
+    for( int unitIndex = 0; unitIndex < 27; unitIndex++ )
+    {
+        //size values that can only go in size spots between them
+        uint16_t positions[9];
+        for( int value = 1; value <= 9; value++ )
+        {
+            positions[value - 1] = GetPositionsOfValue( _sudokuBoard, unitIndex, value );
         }
 
-        if( solver.DidSolvePuzzle() )
+        auto found = [&]( uint16_t values, uint16_t spots )
         {
-            //Though solved we just want to advance one step
-            _sudokuBoard = possibleSolvers[i].GetBoardSolving();
+            int eliminated = EliminateFromUnit( _sudokuBoard, unitIndex, AllCandidates & ~values, [spots]( int i ) { return ( spots & ( 1 << i ) ) == 0; } );
+            _stats.candidatesEliminated += eliminated;
+            return eliminated != 0;
+        };
+        if( FindSubset( positions, size, found ) )
             return true;
+    }
+
+    return false;
+}
+
+bool SudokuSolver::EliminateFish( int size )
+{
+    PhaseTimer phaseTimer( _stats.eliminatingSeconds );
+
+    if( _sudokuBoard.IsBoardSolved() || !IsBoardValid( _sudokuBoard ))
+      return false;
+
+    for( int value = 1; value <= 9; value++ )
+    {
+        //size rows where the value can only go in size cols between them, then the same with cols.
+        //Position i in a row is col i and position i in a col is row i.
+        for( int baseUnit = 0; baseUnit <= 9; baseUnit += 9 )
+        {
+            int coverUnit = 9 - baseUnit;
+
+            uint16_t positions[9];
+            for( int line = 0; line < 9; line++ )
+            {
+                positions[line] = GetPositionsOfValue( _sudokuBoard, baseUnit + line, value );
+            }
+
+            auto found = [&]( uint16_t baseLines, uint16_t coverLines )
+            {
+                int eliminated = 0;
+                for( int line = 0; line < 9; line++ )
+                {
+                    if( coverLines & ( 1 << line ) )
+                        eliminated += EliminateFromUnit( _sudokuBoard, coverUnit + line, CandidateBit( value ), [baseLines]( int i ) { return ( baseLines & ( 1 << i ) ) != 0; } );
+                }
+                _stats.candidatesEliminated += eliminated;
+                return eliminated != 0;
+            };
+            if( FindSubset( positions, size, found ) )
+                return true;
         }
+    }
+
+    return false;
+}
+
+bool SudokuSolver::Propagate()
+{
+    if( !IsBoardValid( _sudokuBoard ) )
+        return false;
+
+    int trailSize = _sudokuBoard.GetTrailSize();
+    if( !PropagateSingles( _sudokuBoard, _stats ) )
+    {
+        _sudokuBoard.UndoTo( trailSize );
+        return false;
+    }
+    return true;
+}
+
+const SudokuBoard& SudokuSolver::Solve()
+{
+    PhaseTimer phaseTimer( _stats.searchSeconds );
+
+    if( !IsBoardValid( _sudokuBoard ) )
+        return _sudokuBoard;
+
+    if( _parallelGuesses )
+        SearchInParallel( _sudokuBoard );
+    else
+        Search( _sudokuBoard );
+    return _sudokuBoard;
+}
 
-        i++;
+bool SudokuSolver::Search( SudokuBoard& sudokuBoard )
+{
+    if( _stopSearch != nullptr && _stopSearch->load( std::memory_order_relaxed ) )
+        return false;
+
+    int trailSize = sudokuBoard.GetTrailSize();
+
+    if( !PropagateSingles( sudokuBoard, _stats ) )
+    {
+        sudokuBoard.UndoTo( trailSize );
+        return false;
     }
 
-    for( int i=0; i<possibleSolvers.size(); )
+    int index = sudokuBoard.FindSpotWithFewestCandidates();
+    if( index < 0 )
+        return true;
+
+    //Parallel branches never have a table, so a search stopped early is never stored as dead
+    uint64_t hash = sudokuBoard.GetHash();
+    bool isSolved = false;
+    if( _transpositions != nullptr && FindTransposition( sudokuBoard, isSolved ) )
     {
-        SudokuSolver solver = possibleSolvers[i];
+        if( !isSolved )
+            sudokuBoard.UndoTo( trailSize );
+        return isSolved;
+    }
 
-        while( solver.SolveOneStep() );
+    int row = index / 9;
+    int col = index % 9;
+    _guessDepth++;
+    _stats.maxGuessDepth = std::max( _stats.maxGuessDepth, _guessDepth );
+    for( int guess : GetCandidateValues( sudokuBoard.GetCandidates( row, col ) ) )
+    {
+        sudokuBoard.Place( row, col, guess );
+        _stats.guesses++;
 
-        if( solver.DidSolvePuzzle() )
+        if( Search( sudokuBoard ) )
         {
-            //Though solved we just want to advance one step
-            _sudokuBoard = possibleSolvers[i].GetBoardSolving();
+            _guessDepth--;
+            if( _transpositions != nullptr )
+                _transpositions->StoreSolved( hash, sudokuBoard );
             return true;
         }
-        else
+
+        sudokuBoard.Undo();
+        _stats.backtracks++;
+    }
+    _guessDepth--;
+
+    if( _transpositions != nullptr )
+        _transpositions->StoreDead( hash );
+    sudokuBoard.UndoTo( trailSize );
+    return false;
+}
+
+//Looks the board up in _transpositions; returns false if it is not there.  A solved board is
+//filled in from the stored solution unless that disagrees with the board, which only two boards
+//with the same hash could do, and then counts as not found.
+bool SudokuSolver::FindTransposition( SudokuBoard& sudokuBoard, bool& isSolved )
+{
+    uint8_t packedSolution[PackedBoardSize];
+    TranspositionResult known = _transpositions->Find( sudokuBoard.GetHash(), packedSolution );
+    if( known == SolvedBoard )
+    {
+        int trailSize = sudokuBoard.GetTrailSize();
+        for( int index = 0; index < 9*9 && known == SolvedBoard; index++ )
         {
-            possibleSolvers.erase( possibleSolvers.begin() + i );
-            continue;
+            int row = index / 9;
+            int col = index % 9;
+            int value = ( packedSolution[index / 2] >> ( 4 * ( index % 2 ) ) ) & 0xF;
+            if( sudokuBoard.GetAt( row, col ) != 0 )
+            {
+                if( sudokuBoard.GetAt( row, col ) != value )
+                    known = UnknownBoard;
+            }
+            else if( value == 0 || !( sudokuBoard.GetCandidates( row, col ) & CandidateBit( value ) ) )
+                known = UnknownBoard;
+            else
+                sudokuBoard.Place( row, col, value );
         }
 
-        i++;
+        if( known == UnknownBoard )
+            sudokuBoard.UndoTo( trailSize );
     }
 
-   return false;
+    if( known == UnknownBoard )
+    {
+        _stats.transpositionMisses++;
+        return false;
+    }
+
+    _stats.transpositionHits++;
+    isSolved = known == SolvedBoard;
+    return true;
+}
+
+bool SudokuSolver::SearchInParallel( SudokuBoard& sudokuBoard )
+{
+    int trailSize = sudokuBoard.GetTrailSize();
+
+    if( !PropagateSingles( sudokuBoard, _stats ) )
+    {
+        sudokuBoard.UndoTo( trailSize );
+        return false;
+    }
+
+    int index = sudokuBoard.FindSpotWithFewestCandidates();
+    if( index < 0 )
+        return true;
+
+    int row = index / 9;
+    int col = index % 9;
+
+    CandidateValues guesses = GetCandidateValues( sudokuBoard.GetCandidates( row, col ) );
+    std::atomic<bool> isSolved( false );
+    SudokuBoard solution = sudokuBoard;
+    SolveStats branchStats[9];
+    std::vector<std::thread> branches;
+
+    for( int i = 0; i < guesses.count; i++ )
+    {
+        branches.emplace_back( [&, i]()
+        {
+            SudokuSolver branch( sudokuBoard );
+            branch._stopSearch = &isSolved;
+            branch._guessDepth = _guessDepth + 1;
+            branch._sudokuBoard.Place( row, col, guesses.values[i] );
+
+            //Only the first branch to finish gets to write the solution
+            if( branch.Search( branch._sudokuBoard ) && !isSolved.exchange( true ) )
+            {
+                solution = branch._sudokuBoard;
+            }
+            branchStats[i] = branch.GetStats();
+        });
+    }
+
+    for( std::thread& branch : branches )
+    {
+        branch.join();
+    }
+
+    _stats.boardCopies += guesses.count + 1;
+    _stats.guesses += guesses.count;
+    _stats.maxGuessDepth = std::max( _stats.maxGuessDepth, _guessDepth + 1 );
+    for( int i = 0; i < guesses.count; i++ )
+    {
+        _stats.Add( branchStats[i] );
+    }
+
+    if( isSolved )
+    {
+        sudokuBoard = solution;
+        return true;
+    }
+
+    sudokuBoard.UndoTo( trailSize );
+    return false;
+}
+
+int SudokuSolver::CountSolutions( int limit )
+{
+    return CountSolutions( limit, 0 ).count;
+}
+
+SolutionCount SudokuSolver::CountSolutions( int limit, int solutionsToKeep )
+{
+    PhaseTimer phaseTimer( _stats.searchSeconds );
+
+    SolutionCount result;
+    if( limit <= 0 || !IsBoardValid( _sudokuBoard ) )
+        return result;
+
+    SudokuBoard sudokuBoard = _sudokuBoard;
+    _stats.boardCopies++;
+    if( _parallelGuesses )
+        CountSolutionsInParallel( sudokuBoard, limit, solutionsToKeep, result );
+    else
+        CountSolutions( sudokuBoard, limit, solutionsToKeep, result );
+    return result;
+}
+
+//Places singles and takes out the candidates EliminateSeenByAllSpots finds until neither does
+//anything more.  Returns false if the board turns out to have no solution.
+bool SudokuSolver::PropagateForCounting( SudokuBoard& sudokuBoard )
+{
+    for( ;; )
+    {
+        if( !PropagateSingles( sudokuBoard, _stats ) )
+            return false;
+
+        int eliminated = EliminateSeenByAllSpots( sudokuBoard );
+        if( eliminated == 0 )
+            return true;
+        _stats.candidatesEliminated += eliminated;
+    }
+}
+
+//Returns true once the count reaches limit.  Takes candidates out of sudokuBoard that Undo would
+//not give back, so it leaves it wherever the search ended and each guess starts from a copy.
+bool SudokuSolver::CountSolutions( SudokuBoard& sudokuBoard, int limit, int solutionsToKeep, SolutionCount& result )
+{
+    if( _solutionsFound != nullptr && _solutionsFound->load( std::memory_order_relaxed ) >= limit )
+        return true;
+
+    if( !PropagateForCounting( sudokuBoard ) )
+        return false;
+
+    int index = sudokuBoard.FindSpotWithFewestCandidates();
+    if( index < 0 )
+    {
+        result.count++;
+        if( static_cast<int>( result.solutions.size() ) < solutionsToKeep )
+            result.solutions.push_back( sudokuBoard );
+
+        if( _solutionsFound != nullptr )
+            return _solutionsFound->fetch_add( 1 ) + 1 >= limit;
+        return result.count >= limit;
+    }
+
+    int row = index / 9;
+    int col = index % 9;
+    SudokuBoard propagated = sudokuBoard;
+    _stats.boardCopies++;
+    for( int guess : GetCandidateValues( propagated.GetCandidates( row, col ) ) )
+    {
+        sudokuBoard = propagated;
+        sudokuBoard.Place( row, col, guess );
+        _stats.guesses++;
+
+        if( CountSolutions( sudokuBoard, limit, solutionsToKeep, result ) )
+            return true;
+        _stats.backtracks++;
+    }
+
+    return false;
+}
+
+void SudokuSolver::CountSolutionsInParallel( SudokuBoard& sudokuBoard, int limit, int solutionsToKeep, SolutionCount& result )
+{
+    if( !PropagateForCounting( sudokuBoard ) )
+        return;
+
+    int index = sudokuBoard.FindSpotWithFewestCandidates();
+    if( index < 0 )
+    {
+        CountSolutions( sudokuBoard, limit, solutionsToKeep, result );
+        return;
+    }
+
+    int row = index / 9;
+    int col = index % 9;
+
+    CandidateValues guesses = GetCandidateValues( sudokuBoard.GetCandidates( row, col ) );
+    std::atomic<int> solutionsFound( 0 );
+    SolutionCount branchResults[9];
+    SolveStats branchStats[9];
+    std::vector<std::thread> branches;
+
+    for( int i = 0; i < guesses.count; i++ )
+    {
+        branches.emplace_back( [&, i]()
+        {
+            SudokuSolver branch( sudokuBoard );
+            branch._solutionsFound = &solutionsFound;
+            branch._sudokuBoard.Place( row, col, guesses.values[i] );
+            branch.CountSolutions( branch._sudokuBoard, limit, solutionsToKeep, branchResults[i] );
+            branchStats[i] = branch.GetStats();
+        });
+    }
+
+    for( std::thread& branch : branches )
+    {
+        branch.join();
+    }
+
+    _stats.boardCopies += guesses.count;
+    _stats.guesses += guesses.count;
+    for( int i = 0; i < guesses.count; i++ )
+    {
+        _stats.Add( branchStats[i] );
+        for( SudokuBoard& solution : branchResults[i].solutions )
+        {
+            if( static_cast<int>( result.solutions.size() ) < solutionsToKeep )
+                result.solutions.push_back( solution );
+        }
+    }
+
+    //Branches can each find one more after the others have reached the limit between them
+    result.count = std::min( solutionsFound.load(), limit );
+}
+
+bool SudokuSolver::IsBoardValid( const SudokuBoard& sudokuBoard )
+{
+    _stats.validityChecks++;
+    return sudokuBoard.IsBoardValid();
 }
 
 bool SudokuSolver::DidSolvePuzzle() const
@@ -475,4 +1225,42 @@ bool SudokuSolver::DidSolvePuzzle() const
 const SudokuBoard& SudokuSolver::GetBoardSolving() const
 {
     return _sudokuBoard;
+}
+
+void SudokuSolver::ResetStats()
+{
+    _stats = SolveStats();
+}
+
+void SolveStats::Add( const SolveStats& other )
+{
+    missingValuePlacements += other.missingValuePlacements;
+    only3x3SpotPlacements += other.only3x3SpotPlacements;
+    rowColSpotPlacements += other.rowColSpotPlacements;
+    tryingPossibilitiesPlacements += other.tryingPossibilitiesPlacements;
+    takingGuessPlacements += other.takingGuessPlacements;
+    searchSinglePlacements += other.searchSinglePlacements;
+
+    candidatesEliminated += other.candidatesEliminated;
+    hardestStrategy = HarderStrategy( hardestStrategy, other.hardestStrategy );
+
+    boardCopies += other.boardCopies;
+    validityChecks += other.validityChecks;
+
+    guesses += other.guesses;
+    backtracks += other.backtracks;
+    maxGuessDepth = std::max( maxGuessDepth, other.maxGuessDepth );
+
+    transpositionHits += other.transpositionHits;
+    transpositionMisses += other.transpositionMisses;
+
+    scratchAllocations += other.scratchAllocations;
+
+    missingValueSeconds += other.missingValueSeconds;
+    only3x3SpotSeconds += other.only3x3SpotSeconds;
+    rowColSpotSeconds += other.rowColSpotSeconds;
+    tryingPossibilitiesSeconds += other.tryingPossibilitiesSeconds;
+    takingGuessSeconds += other.takingGuessSeconds;
+    eliminatingSeconds += other.eliminatingSeconds;
+    searchSeconds += other.searchSeconds;
 }
\ No newline at end of file
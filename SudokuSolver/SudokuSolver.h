@@ -2,24 +2,177 @@
 
 #include "SudokuBoard.h"
 
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TranspositionTable;
+
+//The strategies SolveOneStep tries, cheapest first.  The hardest one a puzzle needed says how
+//difficult it is.
+enum SolveStrategy : uint8_t
+{
+   MissingValueStrategy,
+   Only3x3SpotStrategy,
+   RowColSpotStrategy,
+   PointingPairStrategy,
+   BoxLineReductionStrategy,
+   NakedPairStrategy,
+   HiddenPairStrategy,
+   NakedTripleStrategy,
+   HiddenTripleStrategy,
+   XWingStrategy,
+   SwordfishStrategy,
+   TryingPossibilitiesStrategy,
+   TakingGuessStrategy,
+   StrategyCount,
+   NoStrategy = StrategyCount
+};
+
+const char* GetStrategyName( SolveStrategy strategy );
+//Parses the names GetStrategyName gives; returns false for anything else
+bool ParseSolveStrategy( const std::string& name, SolveStrategy& strategy );
+
+//What a solver did, for finding out why a puzzle is slow
+struct SolveStats
+{
+   //Values placed by each strategy
+   uint64_t missingValuePlacements = 0;
+   uint64_t only3x3SpotPlacements = 0;
+   uint64_t rowColSpotPlacements = 0;
+   uint64_t tryingPossibilitiesPlacements = 0;
+   uint64_t takingGuessPlacements = 0;
+   uint64_t searchSinglePlacements = 0;//Singles placed while searching
+
+   //Candidates ruled out by the strategies that do not place values (pairs, X-Wing...)
+   uint64_t candidatesEliminated = 0;
+
+   //The hardest strategy SolveOneStep had to use
+   SolveStrategy hardestStrategy = NoStrategy;
+
+   uint64_t boardCopies = 0;
+   uint64_t validityChecks = 0;
+
+   uint64_t guesses = 0;
+   uint64_t backtracks = 0;
+   int maxGuessDepth = 0;
+
+   //Boards Search looked up in its TranspositionTable
+   uint64_t transpositionHits = 0;
+   uint64_t transpositionMisses = 0;
+
+   //Blocks the thread's ScratchArena had to take from the heap; none once it has grown enough
+   uint64_t scratchAllocations = 0;
+
+   //Wall time spent in each strategy.  SolveOneTakingGuess searches so its time includes search
+   //time; searchSeconds is only the time in Solve().
+   double missingValueSeconds = 0;
+   double only3x3SpotSeconds = 0;
+   double rowColSpotSeconds = 0;
+   double tryingPossibilitiesSeconds = 0;
+   double takingGuessSeconds = 0;
+   double eliminatingSeconds = 0;
+   double searchSeconds = 0;
+
+   void Add( const SolveStats& other );
+};
+
+//What CountSolutions found
+struct SolutionCount
+{
+   int count = 0;//Stops at the limit, so count == limit means at least that many
+   std::vector<SudokuBoard> solutions;//The first ones found, up to the number asked for
+};
+
 class SudokuSolver
 {
 public:
    SudokuSolver( const SudokuBoard& sudokuBoard );
 
-   //Tries to place a single number.  Returns false if no replacement made
+   //Tries to place a single number.  Returns false if no replacement made.  Goes through the
+   //enabled strategies cheapest first; when one rules out candidates it starts over from the
+   //cheapest.
    bool SolveOneStep();
 
+   //All strategies are enabled to begin with
+   void SetStrategyEnabled( SolveStrategy strategy, bool enabled );
+   bool IsStrategyEnabled( SolveStrategy strategy ) const;
+
    bool SolveOneMissingValue();//If only one possible value for a spot it will use it
    bool SolveOne3x3OnlySpotForValue();//Will check it's values if any other spot in 3x3 area works
    bool SolveOneRowColSpotForValue();//Will check if it's values if any other spot in row/col work
    bool SolveOneTryingPossibilities();//Will use it possible values and make sure other spots have possibilites and board is still valid
-   bool SolveOneTakingGuess();
+   bool SolveOneTakingGuess();//Will search for the solution and place the value of the spot with the fewest possibilities
+
+   //These only rule out candidates.  Each one acts on the first pattern it finds that removes
+   //something and returns false if there was none.
+   bool EliminatePointingPairs();//A value only in one row/col of a 3x3 grid cannot be elsewhere on that row/col
+   bool EliminateBoxLineReduction();//A value only in one 3x3 grid of a row/col cannot be elsewhere in that grid
+   bool EliminateNakedPairs();//Two spots of a unit with the same two candidates keep them from the rest of the unit
+   bool EliminateHiddenPairs();//Two values only in the same two spots of a unit leave those spots no other candidates
+   bool EliminateNakedTriples();
+   bool EliminateHiddenTriples();
+   bool EliminateXWing();//A value only in the same two cols of two rows cannot be elsewhere in those cols (and the other way around)
+   bool EliminateSwordfish();//The same with three rows and cols
+
+   //Places every naked and hidden single until there are none left, only rechecking the spots and
+   //units around each placed value.  Returns false, leaving the board as it was, if that shows the
+   //board has no solution.
+   bool Propagate();
+
+   //Solves the whole puzzle with a depth first search, placing singles after every guess and
+   //undoing back to the guess when it fails.  Check DidSolvePuzzle() for whether it worked.
+   const SudokuBoard& Solve();
+
+   //Searches like Solve but keeps going after a solution, stopping once it has found limit of them.
+   //The board is left as it was.  CountSolutions( 2 ) == 1 means the puzzle has a unique solution.
+   int CountSolutions( int limit );
+   //The same, also keeping the first solutionsToKeep solutions.  With SetParallelGuesses on, each
+   //value of the first guessed spot is counted on its own thread and all of them stop once they
+   //have found limit between them; the solutions are then kept in the order of those values.
+   SolutionCount CountSolutions( int limit, int solutionsToKeep );
+
+   //When on, Solve, SolveOneTakingGuess and CountSolutions search each value of the first guessed
+   //spot on its own thread and the first one to find a solution stops the others.  Meant for
+   //single hard puzzles; batches are better off solving one puzzle per thread.
+   void SetParallelGuesses( bool parallelGuesses ) { _parallelGuesses = parallelGuesses; }
+
+   //Solve and SolveOneTakingGuess look up every board they would guess on in transpositions and
+   //store the ones they finish with, so searching placements already searched is skipped.  Not
+   //owned; one per thread.  Left out of SetParallelGuesses branches and CountSolutions.
+   void SetTranspositionTable( TranspositionTable* transpositions ) { _transpositions = transpositions; }
 
    bool DidSolvePuzzle() const;
 
    const SudokuBoard& GetBoardSolving() const;
 
+   //Counted from construction or the last ResetStats
+   const SolveStats& GetStats() const { return _stats; }
+   void ResetStats();
+
 private:
+   bool Search( SudokuBoard& sudokuBoard );
+   bool SearchInParallel( SudokuBoard& sudokuBoard );
+   bool CountSolutions( SudokuBoard& sudokuBoard, int limit, int solutionsToKeep, SolutionCount& result );
+   void CountSolutionsInParallel( SudokuBoard& sudokuBoard, int limit, int solutionsToKeep, SolutionCount& result );
+   bool PropagateForCounting( SudokuBoard& sudokuBoard );
+   bool FindTransposition( SudokuBoard& sudokuBoard, bool& isSolved );
+   bool IsBoardValid( const SudokuBoard& sudokuBoard );
+   bool EliminateNakedSubset( int size );
+   bool EliminateHiddenSubset( int size );
+   bool EliminateFish( int size );
+
    SudokuBoard _sudokuBoard;
+   bool _parallelGuesses;
+   //A bit per SolveStrategy
+   uint16_t _enabledStrategies;
+   //Set by another branch's thread once it has found a solution
+   const std::atomic<bool>* _stopSearch;
+   //Solutions found by all the branches of a parallel CountSolutions
+   std::atomic<int>* _solutionsFound;
+   TranspositionTable* _transpositions;
+
+   SolveStats _stats;
+   int _guessDepth;
 };
\ No newline at end of file
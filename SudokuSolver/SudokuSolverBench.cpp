@@ -0,0 +1,427 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "BoardKernels.h"
+#include "GridSolver.h"
+#include "LockstepSolver.h"
+#include "PackedPuzzle.h"
+#include "PuzzleParser.h"
+#include "PuzzleGenerator.h"
+#include "SolverEngine.h"
+#include "SudokuBoard.h"
+#include "SudokuSolver.h"
+#include "TranspositionTable.h"
+
+//Every heap allocation in the program goes through here so the benchmarks can report them
+namespace
+{
+   std::atomic<size_t> AllocationCount( 0 );
+}
+
+void* operator new( std::size_t size )
+{
+   AllocationCount.fetch_add( 1, std::memory_order_relaxed );
+   if( void* memory = std::malloc( size == 0 ? 1 : size ) )
+      return memory;
+   throw std::bad_alloc();
+}
+
+void operator delete( void* memory ) noexcept
+{
+   std::free( memory );
+}
+
+void operator delete( void* memory, std::size_t ) noexcept
+{
+   std::free( memory );
+}
+
+namespace
+{
+   struct Corpus
+   {
+      std::string name;
+      std::vector<SudokuBoard> boards;
+   };
+
+   //The puzzles directory has one file per corpus in the --batch line format
+   std::vector<Corpus> LoadCorpora()
+   {
+      std::vector<Corpus> corpora;
+      for( const char* name : { "classic", "classic-hard", "knight", "king", "queen" } )
+      {
+         Corpus corpus;
+         corpus.name = name;
+
+         std::ifstream file( std::string( SUDOKU_PUZZLES_DIR ) + "/" + name + ".txt" );
+         std::string line;
+         while( std::getline( file, line ) )
+         {
+            std::array<uint8_t, 9*9> values;
+            BoardType boardType;
+            if( line.empty() || line[0] == '#' || !ParsePuzzle( line, values, boardType ) )
+               continue;
+            corpus.boards.push_back( SudokuBoard( values, boardType ) );
+         }
+
+         if( corpus.boards.empty() )
+         {
+            std::cerr << "No puzzles loaded for " << name << " from " << SUDOKU_PUZZLES_DIR << std::endl;
+            continue;
+         }
+         corpora.push_back( corpus );
+      }
+      return corpora;
+   }
+
+   //Puzzles on the other grid sizes, kept as text for SolveGridPuzzle
+   struct GridCorpus
+   {
+      std::string name;
+      std::vector<std::string> puzzles;
+   };
+
+   std::vector<GridCorpus> LoadGridCorpora()
+   {
+      std::vector<GridCorpus> corpora;
+      for( const char* name : { "grid4x4", "grid6x6", "grid16x16", "grid25x25" } )
+      {
+         GridCorpus corpus;
+         corpus.name = name;
+
+         std::ifstream file( std::string( SUDOKU_PUZZLES_DIR ) + "/" + name + ".txt" );
+         std::string line;
+         while( std::getline( file, line ) )
+         {
+            if( !line.empty() && line[0] != '#' )
+               corpus.puzzles.push_back( line );
+         }
+
+         if( corpus.puzzles.empty() )
+         {
+            std::cerr << "No puzzles loaded for " << name << " from " << SUDOKU_PUZZLES_DIR << std::endl;
+            continue;
+         }
+         corpora.push_back( corpus );
+      }
+      return corpora;
+   }
+
+   //Puzzles per second and heap allocations per puzzle for a benchmark going over a whole corpus
+   //each iteration
+   void SetCorpusCounters( benchmark::State& state, const Corpus& corpus, size_t allocations )
+   {
+      double puzzles = static_cast<double>( state.iterations() ) * corpus.boards.size();
+      state.counters["puzzles/s"] = benchmark::Counter( puzzles, benchmark::Counter::kIsRate );
+      state.counters["allocs/puzzle"] = puzzles > 0 ? allocations / puzzles : 0;
+   }
+
+   void BenchmarkFullSolve( benchmark::State& state, const Corpus& corpus, SolverEngine engine )
+   {
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            SudokuBoard solution = SolveWithEngine( sudokuBoard, engine );
+            benchmark::DoNotOptimize( solution );
+         }
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+   }
+
+   //The same with one TranspositionTable for the corpus, the way each batch solver thread has one
+   //for the human engine.  It is cleared every iteration so only repeats within the corpus are found.
+   void BenchmarkFullSolveWithTranspositions( benchmark::State& state, const Corpus& corpus, SolverEngine engine )
+   {
+      TranspositionTable transpositions;
+      SolveStats stats;
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         state.PauseTiming();
+         transpositions.Clear();
+         state.ResumeTiming();
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            SudokuBoard solution = SolveWithEngine( sudokuBoard, engine, &stats, &transpositions );
+            benchmark::DoNotOptimize( solution );
+         }
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+      uint64_t lookups = stats.transpositionHits + stats.transpositionMisses;
+      state.counters["hit rate"] = lookups > 0 ? static_cast<double>( stats.transpositionHits ) / lookups : 0;
+   }
+
+   //The whole corpus at once, the way the batch solver hands puzzles to the lockstep engine
+   void BenchmarkSolveBatch( benchmark::State& state, const Corpus& corpus )
+   {
+      std::vector<SudokuBoard> boards;
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         boards.assign( corpus.boards.begin(), corpus.boards.end() );
+         SolveBatch( boards );
+         benchmark::DoNotOptimize( boards.data() );
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+   }
+
+   //Time per placed value when stepping like the hint feature
+   void BenchmarkSolveOneStep( benchmark::State& state, const Corpus& corpus )
+   {
+      size_t steps = 0;
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            SudokuSolver solver( sudokuBoard );
+            while( solver.SolveOneStep() )
+               steps++;
+            benchmark::DoNotOptimize( solver.GetBoardSolving() );
+         }
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+      state.counters["time/step"] = benchmark::Counter( static_cast<double>( steps ), benchmark::Counter::kIsRate | benchmark::Counter::kInvert );
+   }
+
+   //One call of a strategy on each puzzle as given
+   void BenchmarkStrategy( benchmark::State& state, const Corpus& corpus, bool ( SudokuSolver::*strategy )() )
+   {
+      size_t placed = 0;
+      for( auto _ : state )
+      {
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            SudokuSolver solver( sudokuBoard );
+            if( ( solver.*strategy )() )
+               placed++;
+            benchmark::DoNotOptimize( solver.GetBoardSolving() );
+         }
+      }
+      double calls = static_cast<double>( state.iterations() ) * corpus.boards.size();
+      state.counters["calls/s"] = benchmark::Counter( calls, benchmark::Counter::kIsRate );
+      state.counters["placed"] = calls > 0 ? placed / calls : 0;
+   }
+
+   void BenchmarkValidation( benchmark::State& state, const Corpus& corpus, bool ( SudokuBoard::*isValid )() const )
+   {
+      for( auto _ : state )
+      {
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            benchmark::DoNotOptimize( ( sudokuBoard.*isValid )() );
+         }
+      }
+      double checks = static_cast<double>( state.iterations() ) * corpus.boards.size();
+      state.counters["checks/s"] = benchmark::Counter( checks, benchmark::Counter::kIsRate );
+   }
+
+   //The whole-board loops SudokuBoard hands to BoardKernels, with each kernel set the CPU runs
+   void BenchmarkKernels( benchmark::State& state, const Corpus& corpus, BoardKernelSet kernelSet )
+   {
+      BoardKernelSet previousKernelSet = GetBoardKernelSet();
+      UseBoardKernelSet( kernelSet );
+
+      std::array<uint8_t, 9*9> counts;
+      for( auto _ : state )
+      {
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            benchmark::DoNotOptimize( sudokuBoard.FindSpotWithFewestCandidates() );
+            sudokuBoard.CountCandidatesOfAllSpots( counts );
+            benchmark::DoNotOptimize( counts );
+            benchmark::DoNotOptimize( sudokuBoard.IsBoardValidFullScan() );
+         }
+      }
+      UseBoardKernelSet( previousKernelSet );
+
+      double boards = static_cast<double>( state.iterations() ) * corpus.boards.size();
+      state.counters["boards/s"] = benchmark::Counter( boards, benchmark::Counter::kIsRate );
+   }
+
+   //Reading the corpus back from its text lines against from packed records
+   void BenchmarkLoadText( benchmark::State& state, const Corpus& corpus )
+   {
+      const char* boardTypeTags[] = { "", "knight:", "king:", "queen:" };
+      std::vector<std::string> lines;
+      for( const SudokuBoard& sudokuBoard : corpus.boards )
+      {
+         std::string line = boardTypeTags[sudokuBoard.GetBoardType()];
+         for( int index = 0; index < 9*9; index++ )
+            line += static_cast<char>( '0' + sudokuBoard.GetAt( index / 9, index % 9 ) );
+         lines.push_back( line );
+      }
+
+      std::array<uint8_t, 9*9> values;
+      BoardType boardType;
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         for( const std::string& line : lines )
+         {
+            ParsePuzzle( line, values, boardType );
+            SudokuBoard sudokuBoard( values, boardType );
+            benchmark::DoNotOptimize( sudokuBoard );
+         }
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+   }
+
+   void BenchmarkLoadPacked( benchmark::State& state, const Corpus& corpus )
+   {
+      std::string records;
+      for( const SudokuBoard& sudokuBoard : corpus.boards )
+         AppendPackedRecord( records, sudokuBoard, nullptr, false );
+
+      const uint8_t* data = reinterpret_cast<const uint8_t*>( records.data() );
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         for( size_t i = 0; i < corpus.boards.size(); i++ )
+         {
+            PackedPuzzleView record( data + i * GetPackedRecordSize( false ), false );
+            SudokuBoard sudokuBoard = record.GetBoard();
+            benchmark::DoNotOptimize( sudokuBoard );
+         }
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+   }
+
+   //What the generator does for every clue it tries to take away
+   void BenchmarkCountSolutions( benchmark::State& state, const Corpus& corpus )
+   {
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         for( const SudokuBoard& sudokuBoard : corpus.boards )
+         {
+            SudokuSolver solver( sudokuBoard );
+            benchmark::DoNotOptimize( solver.CountSolutions( 2 ) );
+         }
+      }
+      SetCorpusCounters( state, corpus, AllocationCount - allocationsBefore );
+   }
+
+   void BenchmarkGenerate( benchmark::State& state, BoardType boardType )
+   {
+      GeneratorOptions options;
+      options.boardType = boardType;
+      PuzzleGenerator generator( 0 );
+      SudokuBoard puzzle( "", boardType );
+      size_t generated = 0;
+      for( auto _ : state )
+      {
+         generator.Seed( generated );
+         if( generator.Generate( options, puzzle ) )
+            generated++;
+         benchmark::DoNotOptimize( puzzle );
+      }
+      state.counters["puzzles/s"] = benchmark::Counter( static_cast<double>( generated ), benchmark::Counter::kIsRate );
+   }
+
+   void BenchmarkGridSolve( benchmark::State& state, const GridCorpus& corpus )
+   {
+      std::string solution;
+      size_t allocationsBefore = AllocationCount;
+      for( auto _ : state )
+      {
+         for( const std::string& puzzle : corpus.puzzles )
+         {
+            SolveGridPuzzle( puzzle, solution );
+            benchmark::DoNotOptimize( solution );
+         }
+      }
+      double puzzles = static_cast<double>( state.iterations() ) * corpus.puzzles.size();
+      state.counters["puzzles/s"] = benchmark::Counter( puzzles, benchmark::Counter::kIsRate );
+      state.counters["allocs/puzzle"] = puzzles > 0 ? ( AllocationCount - allocationsBefore ) / puzzles : 0;
+   }
+
+   void RegisterGridBenchmarks( const std::vector<GridCorpus>& corpora )
+   {
+      for( const GridCorpus& corpus : corpora )
+      {
+         benchmark::RegisterBenchmark( ( "GridSolve/" + corpus.name ).c_str(), BenchmarkGridSolve, std::cref( corpus ) );
+      }
+   }
+
+   void RegisterBenchmarks( const std::vector<Corpus>& corpora )
+   {
+      const std::pair<const char*, SolverEngine> engines[] = { { "human", HumanStyleEngine }, { "backtracking", BacktrackingEngine }, { "dlx", DancingLinksEngine } };
+      const std::pair<const char*, bool ( SudokuSolver::* )()> strategies[] = {
+         { "SolveOneMissingValue", &SudokuSolver::SolveOneMissingValue },
+         { "SolveOne3x3OnlySpotForValue", &SudokuSolver::SolveOne3x3OnlySpotForValue },
+         { "SolveOneRowColSpotForValue", &SudokuSolver::SolveOneRowColSpotForValue },
+         { "EliminatePointingPairs", &SudokuSolver::EliminatePointingPairs },
+         { "EliminateBoxLineReduction", &SudokuSolver::EliminateBoxLineReduction },
+         { "EliminateNakedPairs", &SudokuSolver::EliminateNakedPairs },
+         { "EliminateHiddenPairs", &SudokuSolver::EliminateHiddenPairs },
+         { "EliminateNakedTriples", &SudokuSolver::EliminateNakedTriples },
+         { "EliminateHiddenTriples", &SudokuSolver::EliminateHiddenTriples },
+         { "EliminateXWing", &SudokuSolver::EliminateXWing },
+         { "EliminateSwordfish", &SudokuSolver::EliminateSwordfish },
+         { "SolveOneTryingPossibilities", &SudokuSolver::SolveOneTryingPossibilities },
+         { "SolveOneTakingGuess", &SudokuSolver::SolveOneTakingGuess } };
+
+      for( const Corpus& corpus : corpora )
+      {
+         for( const auto& engine : engines )
+         {
+            benchmark::RegisterBenchmark( ( "FullSolve/" + std::string( engine.first ) + "/" + corpus.name ).c_str(), BenchmarkFullSolve, std::cref( corpus ), engine.second );
+         }
+         benchmark::RegisterBenchmark( ( "FullSolveWithTranspositions/human/" + corpus.name ).c_str(), BenchmarkFullSolveWithTranspositions, std::cref( corpus ), HumanStyleEngine );
+
+         benchmark::RegisterBenchmark( ( "SolveBatch/" + corpus.name ).c_str(), BenchmarkSolveBatch, std::cref( corpus ) );
+         benchmark::RegisterBenchmark( ( "SolveOneStep/" + corpus.name ).c_str(), BenchmarkSolveOneStep, std::cref( corpus ) );
+
+         for( const auto& strategy : strategies )
+         {
+            benchmark::RegisterBenchmark( ( "Strategy/" + std::string( strategy.first ) + "/" + corpus.name ).c_str(), BenchmarkStrategy, std::cref( corpus ), strategy.second );
+         }
+
+         benchmark::RegisterBenchmark( ( "CountSolutions/" + corpus.name ).c_str(), BenchmarkCountSolutions, std::cref( corpus ) );
+         benchmark::RegisterBenchmark( ( "LoadText/" + corpus.name ).c_str(), BenchmarkLoadText, std::cref( corpus ) );
+         benchmark::RegisterBenchmark( ( "LoadPacked/" + corpus.name ).c_str(), BenchmarkLoadPacked, std::cref( corpus ) );
+         benchmark::RegisterBenchmark( ( "IsBoardValid/" + corpus.name ).c_str(), BenchmarkValidation, std::cref( corpus ), &SudokuBoard::IsBoardValid );
+         benchmark::RegisterBenchmark( ( "IsBoardValidFullScan/" + corpus.name ).c_str(), BenchmarkValidation, std::cref( corpus ), &SudokuBoard::IsBoardValidFullScan );
+
+         for( int kernelSet = ScalarKernels; kernelSet <= GetBestBoardKernelSet(); kernelSet++ )
+         {
+            std::string name = "Kernels/" + std::string( GetBoardKernelSetName( static_cast<BoardKernelSet>( kernelSet ) ) ) + "/" + corpus.name;
+            benchmark::RegisterBenchmark( name.c_str(), BenchmarkKernels, std::cref( corpus ), static_cast<BoardKernelSet>( kernelSet ) );
+         }
+      }
+   }
+}
+
+int main( int argc, char* argv[] )
+{
+   benchmark::Initialize( &argc, argv );
+   if( benchmark::ReportUnrecognizedArguments( argc, argv ) )
+      return 1;
+
+   std::vector<Corpus> corpora = LoadCorpora();
+   RegisterBenchmarks( corpora );
+   std::vector<GridCorpus> gridCorpora = LoadGridCorpora();
+   RegisterGridBenchmarks( gridCorpora );
+
+   const std::pair<const char*, BoardType> boardTypes[] = { { "classic", Traditional }, { "knight", KnightSudoku }, { "king", KingSudoku }, { "queen", QueenSudoku } };
+   for( const auto& boardType : boardTypes )
+   {
+      benchmark::RegisterBenchmark( ( std::string( "Generate/" ) + boardType.first ).c_str(), BenchmarkGenerate, boardType.second );
+   }
+
+   benchmark::RunSpecifiedBenchmarks();
+   benchmark::Shutdown();
+   return 0;
+}
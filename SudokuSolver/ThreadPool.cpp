@@ -0,0 +1,119 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool( int threadCount /*= 0*/ )
+: _stopping( false )
+, _queuedTasks( 0 )
+, _unfinishedTasks( 0 )
+, _sleepingWorkers( 0 )
+, _nextQueue( 0 )
+{
+    if( threadCount <= 0 )
+        threadCount = static_cast<int>( std::thread::hardware_concurrency() );
+    if( threadCount <= 0 )
+        threadCount = 1;
+
+    for( int i = 0; i < threadCount; i++ )
+    {
+        _queues.push_back( std::make_unique<WorkQueue>() );
+    }
+
+    for( int i = 0; i < threadCount; i++ )
+    {
+        _threads.emplace_back( [this, i]() { WorkerLoop( i ); } );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _stopping = true;
+    }
+    _workAvailable.notify_all();
+
+    for( std::thread& thread : _threads )
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit( Task task )
+{
+    WorkQueue& queue = *_queues[_nextQueue++ % _queues.size()];
+    {
+        std::lock_guard<std::mutex> lock( queue.mutex );
+        queue.tasks.push_back( std::move( task ) );
+    }
+    _unfinishedTasks++;
+    _queuedTasks++;
+
+    //A worker counts itself as sleeping before it checks _queuedTasks, so either it sees this task
+    //or this sees it.  Taking the lock makes sure it is really waiting before it is woken.
+    if( _sleepingWorkers > 0 )
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _workAvailable.notify_one();
+    }
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    _allDone.wait( lock, [this]() { return _unfinishedTasks == 0; } );
+}
+
+void ThreadPool::WorkerLoop( int workerIndex )
+{
+    for( ;; )
+    {
+        Task task;
+        if( TryTakeTask( workerIndex, task ) )
+        {
+            _queuedTasks--;
+            task( workerIndex );
+
+            if( --_unfinishedTasks == 0 )
+            {
+                std::lock_guard<std::mutex> lock( _mutex );
+                _allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( _mutex );
+        _sleepingWorkers++;
+        _workAvailable.wait( lock, [this]() { return _queuedTasks > 0 || _stopping; } );
+        _sleepingWorkers--;
+        if( _queuedTasks <= 0 && _stopping )
+            return;
+    }
+}
+
+bool ThreadPool::TryTakeTask( int workerIndex, Task& task )
+{
+    {
+        WorkQueue& own = *_queues[workerIndex];
+        std::lock_guard<std::mutex> lock( own.mutex );
+        if( !own.tasks.empty() )
+        {
+            task = std::move( own.tasks.back() );
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    int queueCount = static_cast<int>( _queues.size() );
+    for( int i = 1; i < queueCount; i++ )
+    {
+        WorkQueue& other = *_queues[( workerIndex + i ) % queueCount];
+        std::lock_guard<std::mutex> lock( other.mutex );
+        if( !other.tasks.empty() )
+        {
+            task = std::move( other.tasks.front() );
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
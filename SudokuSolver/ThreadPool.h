@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//A fixed set of worker threads, each with its own queue of tasks.  A worker takes from the back of
+//its own queue and, when that is empty, steals from the front of the other workers' queues.  It
+//only sleeps once there is nothing in any queue.
+class ThreadPool
+{
+public:
+   //The task is told which worker runs it so it can use per-thread scratch state
+   typedef std::function<void( int workerIndex )> Task;
+
+   //threadCount of 0 uses every core
+   explicit ThreadPool( int threadCount = 0 );
+   ~ThreadPool();
+
+   ThreadPool( const ThreadPool& ) = delete;
+   ThreadPool& operator=( const ThreadPool& ) = delete;
+
+   int GetThreadCount() const { return static_cast<int>( _threads.size() ); }
+
+   void Submit( Task task );
+
+   //Blocks until every submitted task has finished
+   void Wait();
+
+private:
+   struct WorkQueue
+   {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+   };
+
+   void WorkerLoop( int workerIndex );
+   bool TryTakeTask( int workerIndex, Task& task );
+
+   std::vector<std::unique_ptr<WorkQueue>> _queues;
+   std::vector<std::thread> _threads;
+
+   //Only taken to go to sleep, to wake a sleeping worker and to wait for the last task
+   std::mutex _mutex;
+   std::condition_variable _workAvailable;
+   std::condition_variable _allDone;
+   bool _stopping;
+
+   std::atomic<int> _queuedTasks;//Submitted but not taken off a queue yet
+   std::atomic<int> _unfinishedTasks;//Submitted but not finished yet
+   std::atomic<int> _sleepingWorkers;
+
+   std::atomic<unsigned> _nextQueue;
+};
@@ -0,0 +1,89 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+TranspositionTable::TranspositionTable( size_t capacity /*= DefaultCapacity*/ )
+{
+    size_t setCount = 1;
+    while( setCount * SetSize < capacity )
+        setCount *= 2;
+
+    _entries.resize( setCount * SetSize );
+    _hands.resize( setCount );
+    _setMask = setCount - 1;
+    Clear();
+}
+
+void TranspositionTable::Clear()
+{
+    for( Entry& entry : _entries )
+    {
+        entry.result = UnknownBoard;
+        entry.referenced = false;
+    }
+    std::fill( _hands.begin(), _hands.end(), static_cast<uint8_t>( 0 ) );
+}
+
+TranspositionResult TranspositionTable::Find( uint64_t hash, uint8_t* packedSolution /*= nullptr*/ )
+{
+    Entry* set = &_entries[( hash & _setMask ) * SetSize];
+    for( int way = 0; way < SetSize; way++ )
+    {
+        Entry& entry = set[way];
+        if( entry.result == UnknownBoard || entry.hash != hash )
+            continue;
+
+        entry.referenced = true;
+        if( entry.result == SolvedBoard && packedSolution != nullptr )
+            std::memcpy( packedSolution, entry.packedSolution, PackedBoardSize );
+        return entry.result;
+    }
+    return UnknownBoard;
+}
+
+void TranspositionTable::StoreDead( uint64_t hash )
+{
+    Entry& entry = EntryToStore( hash );
+    entry.result = DeadBoard;
+}
+
+void TranspositionTable::StoreSolved( uint64_t hash, const SudokuBoard& solution )
+{
+    Entry& entry = EntryToStore( hash );
+    entry.result = SolvedBoard;
+    solution.Pack( entry.packedSolution );
+}
+
+//The entry already holding hash, else an empty one, else whichever one the clock hand stops at
+TranspositionTable::Entry& TranspositionTable::EntryToStore( uint64_t hash )
+{
+    size_t setIndex = hash & _setMask;
+    Entry* set = &_entries[setIndex * SetSize];
+
+    Entry* empty = nullptr;
+    for( int way = 0; way < SetSize; way++ )
+    {
+        if( set[way].result != UnknownBoard && set[way].hash == hash )
+            return set[way];
+        if( set[way].result == UnknownBoard && empty == nullptr )
+            empty = &set[way];
+    }
+
+    if( empty == nullptr )
+    {
+        //Passing an entry clears its referenced flag, so the hand goes round at most twice
+        uint8_t& hand = _hands[setIndex];
+        while( set[hand].referenced )
+        {
+            set[hand].referenced = false;
+            hand = static_cast<uint8_t>( ( hand + 1 ) % SetSize );
+        }
+        empty = &set[hand];
+        hand = static_cast<uint8_t>( ( hand + 1 ) % SetSize );
+    }
+
+    empty->hash = hash;
+    empty->referenced = false;
+    return *empty;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "SudokuBoard.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//What a finished search found out about the placements of a board
+enum TranspositionResult : uint8_t
+{
+   UnknownBoard,
+   DeadBoard,//No solution
+   SolvedBoard
+};
+
+//Remembers boards searches have finished with by SudokuBoard::GetHash() so that a later search
+//reaching the same placements does not have to search them again.  Whether placements can be
+//finished does not depend on how they were reached, so one table can be shared by every puzzle a
+//thread solves.  Holds a fixed number of boards in sets of SetSize; once a set is full a new board
+//takes the place of one that has not been found since the set's clock hand last passed it.  Not
+//thread safe, so one per thread.
+class TranspositionTable
+{
+public:
+   static constexpr int SetSize = 4;
+   static constexpr size_t DefaultCapacity = 1 << 15;
+
+   //capacity is rounded up to a power of 2 no smaller than SetSize
+   explicit TranspositionTable( size_t capacity = DefaultCapacity );
+
+   size_t GetCapacity() const { return _entries.size(); }
+   void Clear();
+
+   //packedSolution, when given, gets the solution of a SolvedBoard packed the way
+   //SudokuBoard::Pack writes it
+   TranspositionResult Find( uint64_t hash, uint8_t* packedSolution = nullptr );
+   void StoreDead( uint64_t hash );
+   void StoreSolved( uint64_t hash, const SudokuBoard& solution );
+
+private:
+   struct Entry
+   {
+      uint64_t hash;
+      TranspositionResult result;
+      bool referenced;//Found since the clock hand last passed it
+      uint8_t packedSolution[PackedBoardSize];
+   };
+
+   Entry& EntryToStore( uint64_t hash );
+
+   std::vector<Entry> _entries;
+   std::vector<uint8_t> _hands;//Clock hand of each set
+   size_t _setMask;
+};
@@ -1,10 +1,263 @@
+#include <array>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
 
+#include "BatchSolver.h"
+#include "PuzzleGenerator.h"
+#include "PuzzleParser.h"
+#include "SolutionCache.h"
 #include "SudokuBoard.h"
 #include "SudokuSolver.h"
 
-int main()
+namespace
 {
+   void PrintUsage()
+   {
+      std::cerr << "Usage: SudokuSolver [--batch [file]] [--engine human|backtracking|dlx|lockstep] [--threads n] [--unordered] [--stats-json file] [--packed-output]" << std::endl;
+      std::cerr << "                    [--cache file]" << std::endl;
+      std::cerr << "  --batch reads one puzzle per line from file (or stdin when no file or -)" << std::endl;
+      std::cerr << "          and writes one solution per line to stdout.  A line is 81 values" << std::endl;
+      std::cerr << "          ('0' or '.' for empty) optionally preceded by knight:, king: or queen:" << std::endl;
+      std::cerr << "  --engine lockstep places the singles of 16 puzzles at once with AVX2" << std::endl;
+      std::cerr << "  --threads solves on n threads, 0 for every core (default 1)" << std::endl;
+      std::cerr << "  --unordered writes solutions as they are ready instead of in input order" << std::endl;
+      std::cerr << "  --stats-json writes a line of JSON with the solver stats of each puzzle to file" << std::endl;
+      std::cerr << "  --packed-output writes each puzzle and its solution as a packed binary record" << std::endl;
+      std::cerr << "          instead; a packed file given to --batch is read as one" << std::endl;
+      std::cerr << "  --cache looks puzzles and their rotations, reflections and relabellings up in file" << std::endl;
+      std::cerr << "          before solving them and saves the new solutions to it afterwards" << std::endl;
+      std::cerr << "Usage: SudokuSolver --pack [file]" << std::endl;
+      std::cerr << "  --pack writes the puzzle lines of file (or stdin) to stdout as packed records" << std::endl;
+      std::cerr << "Usage: SudokuSolver --generate n [--board-type traditional|knight|king|queen] [--clues n]" << std::endl;
+      std::cerr << "                    [--min-strategy name] [--max-strategy name] [--seed n] [--threads n]" << std::endl;
+      std::cerr << "  --generate writes n puzzles with a unique solution to stdout in the --batch format" << std::endl;
+      std::cerr << "  --clues stops taking clues away at n clues (default as few as it can)" << std::endl;
+      std::cerr << "  --min-strategy/--max-strategy limit the hardest strategy a puzzle needs, e.g. nakedPair" << std::endl;
+   }
+
+   int RunGenerate( int argc, char* argv[] )
+   {
+      GeneratorOptions options;
+      size_t count = 0;
+      int threads = 1;
+
+      for( int i = 1; i < argc; i++ )
+      {
+         std::string arg = argv[i];
+         bool isValid = i + 1 < argc;
+         if( arg == "--generate" && isValid )
+            count = std::strtoull( argv[++i], nullptr, 10 );
+         else if( arg == "--board-type" && isValid )
+         {
+            std::string name = argv[++i];
+            isValid = ParseBoardTypeTag( name.data(), name.size(), options.boardType );
+         }
+         else if( arg == "--clues" && isValid )
+            options.targetClues = std::atoi( argv[++i] );
+         else if( arg == "--min-strategy" && isValid )
+            isValid = ParseSolveStrategy( argv[++i], options.minStrategy );
+         else if( arg == "--max-strategy" && isValid )
+            isValid = ParseSolveStrategy( argv[++i], options.maxStrategy );
+         else if( arg == "--seed" && isValid )
+            options.seed = std::strtoull( argv[++i], nullptr, 10 );
+         else if( arg == "--threads" && isValid )
+            threads = std::atoi( argv[++i] );
+         else
+            isValid = false;
+
+         if( !isValid )
+         {
+            PrintUsage();
+            return 1;
+         }
+      }
+
+      std::ios::sync_with_stdio( false );
+
+      size_t generated = GeneratePuzzles( options, count, threads, std::cout );
+      std::cerr << "Generated " << generated << " of " << count << " puzzles" << std::endl;
+      return generated == count ? 0 : 2;
+   }
+
+   int RunPack( int argc, char* argv[] )
+   {
+      if( argc > 3 )
+      {
+         PrintUsage();
+         return 1;
+      }
+
+      std::ifstream file;
+      if( argc == 3 && std::string( argv[2] ) != "-" )
+      {
+         file.open( argv[2] );
+         if( !file )
+         {
+            std::cerr << "Could not open " << argv[2] << std::endl;
+            return 1;
+         }
+      }
+      std::istream& input = file.is_open() ? file : std::cin;
+
+      std::ios::sync_with_stdio( false );
+
+      std::string output;
+      AppendPackedHeader( output, false );
+
+      std::string line;
+      std::array<uint8_t, 9*9> values;
+      size_t lineNumber = 0, packed = 0, invalid = 0;
+      while( std::getline( input, line ) )
+      {
+         lineNumber++;
+         if( line.empty() || line[0] == '#' || line == "\r" )
+            continue;
+
+         BoardType boardType;
+         ParseError error;
+         if( !ParsePuzzle( line, values, boardType, &error ) )
+         {
+            std::cerr << "Line " << lineNumber << ", column " << error.position + 1 << ": " << error.message << std::endl;
+            invalid++;
+            continue;
+         }
+
+         AppendPackedRecord( output, SudokuBoard( values, boardType ), nullptr, false );
+         packed++;
+         if( output.size() >= 64 * 1024 )
+         {
+            std::cout.write( output.data(), output.size() );
+            output.clear();
+         }
+      }
+      std::cout.write( output.data(), output.size() );
+      std::cout.flush();
+
+      std::cerr << "Packed " << packed << " puzzles";
+      if( invalid > 0 )
+         std::cerr << " (" << invalid << " lines that were not puzzles)";
+      std::cerr << std::endl;
+      return invalid == 0 ? 0 : 2;
+   }
+
+   int RunBatch( int argc, char* argv[] )
+   {
+      BatchOptions options;
+      std::string fileName;
+      std::ofstream statsFile;
+      SolutionCache cache;
+      std::string cacheFileName;
+
+      for( int i = 1; i < argc; i++ )
+      {
+         std::string arg = argv[i];
+         if( arg == "--batch" )
+         {
+            if( i + 1 < argc && argv[i + 1][0] != '-' )
+               fileName = argv[++i];
+            else if( i + 1 < argc && std::string( argv[i + 1] ) == "-" )
+               i++;
+         }
+         else if( arg == "--engine" && i + 1 < argc )
+         {
+            if( !ParseSolverEngine( argv[++i], options.engine ) )
+            {
+               PrintUsage();
+               return 1;
+            }
+         }
+         else if( arg == "--threads" && i + 1 < argc )
+         {
+            options.threads = std::atoi( argv[++i] );
+         }
+         else if( arg == "--unordered" )
+         {
+            options.ordered = false;
+         }
+         else if( arg == "--packed-output" )
+         {
+            options.packedOutput = true;
+         }
+         else if( arg == "--stats-json" && i + 1 < argc )
+         {
+            statsFile.open( argv[++i] );
+            if( !statsFile )
+            {
+               std::cerr << "Could not open " << argv[i] << std::endl;
+               return 1;
+            }
+            options.statsOutput = &statsFile;
+         }
+         else if( arg == "--cache" && i + 1 < argc )
+         {
+            cacheFileName = argv[++i];
+            options.cache = &cache;
+         }
+         else
+         {
+            PrintUsage();
+            return 1;
+         }
+      }
+
+      //A file that is there but not a cache is not written over
+      if( !cacheFileName.empty() && !cache.Load( cacheFileName ) && std::ifstream( cacheFileName ) )
+      {
+         std::cerr << cacheFileName << " is not a packed file with solutions" << std::endl;
+         return 1;
+      }
+
+      std::ios::sync_with_stdio( false );
+
+      BatchResult result;
+      PackedPuzzleFile packedFile;
+      if( fileName.empty() )
+      {
+         result = SolvePuzzleStream( std::cin, std::cout, options );
+      }
+      else if( packedFile.Open( fileName ) )
+      {
+         result = SolvePackedPuzzles( packedFile, std::cout, options );
+      }
+      else
+      {
+         std::ifstream file( fileName );
+         if( !file )
+         {
+            std::cerr << "Could not open " << fileName << std::endl;
+            return 1;
+         }
+         result = SolvePuzzleStream( file, std::cout, options );
+      }
+
+      std::cerr << "Solved " << result.solved << " of " << result.puzzles << " puzzles";
+      if( result.invalid > 0 )
+         std::cerr << " (" << result.invalid << " invalid lines)";
+      if( options.cache != nullptr )
+         std::cerr << " (" << result.cached << " from the cache)";
+      std::cerr << std::endl;
+
+      if( options.cache != nullptr && !cache.Save( cacheFileName ) )
+      {
+         std::cerr << "Could not write " << cacheFileName << std::endl;
+         return 1;
+      }
+
+      return result.solved + result.invalid == result.puzzles ? 0 : 2;
+   }
+}
+
+int main( int argc, char* argv[] )
+{
+   if( argc > 1 && std::string( argv[1] ) == "--generate" )
+      return RunGenerate( argc, argv );
+   if( argc > 1 && std::string( argv[1] ) == "--pack" )
+      return RunPack( argc, argv );
+   if( argc > 1 )
+      return RunBatch( argc, argv );
+
    std::cout << "Enter board setup:" << std::endl;
    std::string placements;
    //std::getline(std::cin, placements);